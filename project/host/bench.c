@@ -0,0 +1,17 @@
+/**
+ ******************************************************************************
+ * @file    bench
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   调度器微基准的主机程序：不启动 sloop，直接运行 sl_bench_run 后退出
+ *****************************************************************************/
+
+#include "sloop.h"
+
+void _main(void)
+{
+    /* 注册表为空，tick 信号已启动 */
+    sl_bench_run();
+}
+
+/************************** END OF FILE **************************/
@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ * @file    fleet_node
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   多节点仿真的演示节点程序：各节点按随机周期向总线广播一帧，统计收到的帧
+ *****************************************************************************/
+
+#include "sloop.h"
+
+/* 帧格式：[0x7E][节点号，2 字节][序号，2 字节][填充][校验和] */
+#define FRAME_SYNC 0x7E
+#define FRAME_LEN 16
+
+static uint16_t tx_seq;
+
+/* 接收状态 */
+static uint8_t rx_frame[FRAME_LEN];
+static int rx_len;
+
+static uint32_t rx_ok;
+static uint32_t rx_bad;
+
+/* ============================================================== */
+
+/* 广播一帧 */
+static void node_send(void)
+{
+    uint8_t frame[FRAME_LEN] = {FRAME_SYNC};
+
+    uint8_t sum = 0;
+
+    frame[1] = sl_fleet_node();
+
+    frame[2] = sl_fleet_node() >> 8;
+
+    frame[3] = tx_seq;
+
+    frame[4] = tx_seq >> 8;
+
+    for (int i = 0; i < FRAME_LEN - 1; i++)
+        sum += frame[i];
+
+    frame[FRAME_LEN - 1] = sum;
+
+    if (sl_fleet_send(frame, FRAME_LEN))
+        tx_seq++;
+}
+
+/* 接收并校验帧 */
+static void node_recv(void)
+{
+    uint8_t buf[64];
+
+    int n;
+
+    while ((n = sl_fleet_recv(buf, sizeof buf)) > 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            /* 等待帧头 */
+            if (rx_len == 0 && buf[i] != FRAME_SYNC)
+                continue;
+
+            rx_frame[rx_len++] = buf[i];
+
+            if (rx_len < FRAME_LEN)
+                continue;
+
+            uint8_t sum = 0;
+
+            for (int j = 0; j < FRAME_LEN - 1; j++)
+                sum += rx_frame[j];
+
+            sum == rx_frame[FRAME_LEN - 1] ? rx_ok++ : rx_bad++;
+
+            rx_len = 0;
+        }
+    }
+}
+
+/* 每秒打印一次收发统计 */
+static void node_report(void)
+{
+    sl_printf("node %d: tx %d, rx %d frames, %d bad", sl_fleet_node(), tx_seq, (int)rx_ok, (int)rx_bad);
+}
+
+void _main(void)
+{
+    sloop_init();
+
+    /* 发送周期 50~149ms，由种子决定 */
+    sl_cycle_start(50 + sl_sim_rand() % 100, node_send);
+
+    sl_task_start(node_recv);
+
+    sl_cycle_start(1000, node_report);
+
+    while (1)
+    {
+        sloop();
+    }
+}
+
+/************************** END OF FILE **************************/
@@ -0,0 +1,23 @@
+/**
+ ******************************************************************************
+ * @file    main
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   主机（Linux）入口，对应 Core/Src/main.c，启动 tick 与 RTT 输出后进入 _main
+ *****************************************************************************/
+
+#include "common.h"
+
+void _main(void);
+
+int main(int argc, char **argv)
+{
+    /* 代替 HAL_Init 与时钟配置：启动 1ms tick 信号与 RTT 输出线程，仿真时解析仿真参数 */
+    sl_port_host_start(argc, argv);
+
+    _main();
+
+    return 0;
+}
+
+/************************** END OF FILE **************************/
@@ -0,0 +1,16 @@
+/**
+ ******************************************************************************
+ * @file    main
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   主机构建时代替 Core/Inc/main.h，不包含 HAL 与外设定义
+ *****************************************************************************/
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include "sl_port.h"
+
+#endif /* __MAIN_H */
+
+/************************** END OF FILE **************************/
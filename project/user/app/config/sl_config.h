@@ -25,14 +25,183 @@
 /* 单次任务上限 */
 #define SL_ONCE_LIMIT 16
 
+/* 子 Flow 上限（FLOW_SPAWN/FLOW_CALL 挂接关系） */
+#define SL_FLOW_CHILD_LIMIT 16
+
+/* 单个信号量/互斥量等待队列上限 */
+#define SL_SEM_WAIT_LIMIT 8
+
+/* CPU 负载按任务计时的任务数，须为2的幂，0 为只统计总负载。
+ * 不为 0 时每次任务分发多两次 sl_get_cycle 与一次统计表查找，调试时再打开，如 16 */
+#define SL_LOAD_TASK_NUM 0
+
+/* CPU 负载自动报告周期 ms，0 为不自动报告（可调用 sl_load_report） */
+#define SL_LOAD_REPORT_MS 0
+
+/* 启用主循环与软件定时器延迟直方图，每轮主循环多一次直方图更新，每个 tick 多两次 sl_get_cycle 与一次直方图更新 */
+#define SL_LATENCY_ENABLE 0
+
+/* 启用定时器迟到统计（每个定时器 24 字节 RAM） */
+#define SL_TIMER_STAT_ENABLE 0
+
+/* 启用栈填充与栈峰值检查，栈剩余不足 1/8 时警告 */
+#define SL_STACK_CHECK_ENABLE 1
+
+/* 栈与注册表峰值自动报告周期 ms，0 为不自动报告（可调用 sl_mem_report） */
+#define SL_MEM_REPORT_MS 0
+
+/* 调度热路径（主循环、定时器、单次/并行/互斥任务分发与负载统计）在 SRAM 中执行，占用的 RAM 见 sl_mem_report，
+ * MDK 需使用 MDK-ARM/project.sct，GCC 链接脚本需包含 .RamFunc 段，见 sl_ramfunc */
+#define SL_RAMFUNC_ENABLE 0
+
+/* 启动时运行调度器微基准，结果以 JSON 经 RTT 通道0输出，见 sl_bench.c */
+#define SL_BENCH_ENABLE 0
+
+/* ============================================================== */
+
+/* HAL 以 sloop tick 为唯一时基：重新实现 HAL_GetTick/HAL_Delay/HAL_IncTick，HAL 内部等待期间运行其他并行任务，见 sl_hal.c */
+#define SL_HAL_TICK_ENABLE 0
+
+/* HAL_Delay 无法让出时（嵌套等待）以 WFI 睡眠到下一个中断，0 为空转 */
+#define SL_HAL_DELAY_SLEEP 1
+
+/* ============================================================== */
+
+/* 启用按 CPU 负载调频：低负载时逐档降低 HCLK，负载升高时回到全速，见 sl_gov.c */
+#define SL_GOV_ENABLE 0
+
+/* 负载（0.1%）持续低于此值 SL_GOV_HOLD_MS 后降一档，降一档后负载约翻倍，须小于 SL_GOV_UP 的一半 */
+#define SL_GOV_DOWN 300
+
+/* 负载（0.1%）高于此值时直接回到全速 */
+#define SL_GOV_UP 700
+
+/* 降档前低负载须持续的时间 ms */
+#define SL_GOV_HOLD_MS 1000
+
+/* 档位数，第 n 档 HCLK 为 SYSCLK / 2^n，4 档即 64/32/16/8 MHz */
+#define SL_GOV_LEVELS 4
+
+/* ============================================================== */
+
+/* 启用过载降级：负载持续偏高时按 sl_shed_set 声明的类别拉长或暂停低优先级任务，见 sl_shed.c */
+#define SL_SHED_ENABLE 0
+
+/* 负载（0.1%）持续 SL_SHED_HOLD_MS 高于此值开始降级 */
+#define SL_SHED_ON 850
+
+/* 负载（0.1%）持续 SL_SHED_HOLD_MS 低于此值恢复 */
+#define SL_SHED_OFF 600
+
+/* 开始降级与恢复前负载须持续的时间 ms */
+#define SL_SHED_HOLD_MS 300
+
+/* SL_SHED_STRETCH 类周期任务降级时周期拉长的倍数 */
+#define SL_SHED_FACTOR 4
+
+/* 可声明降级类别的任务数 */
+#define SL_SHED_LIMIT 8
+
 /* ============================================================== */
 
 /* 启用RTT打印 */
 #define SL_RTT_ENABLE 1
 
-/* RTT 打印缓冲区大小 */
+/* RTT 文本日志通道（通道0）缓冲区大小 */
 #define SL_RTT_BUFFER_SIZE 2048
 
+/* RTT 通道满时的处理：SEGGER_RTT_MODE_NO_BLOCK_SKIP 整条丢弃，NO_BLOCK_TRIM 截断，BLOCK_IF_FIFO_FULL 阻塞等待主机读取 */
+#define SL_RTT_TEXT_MODE SEGGER_RTT_MODE_NO_BLOCK_SKIP
+
+/* 文本日志零拷贝：整条日志在关中断下直接格式化进 RTT 缓冲区并一次提交，不会与中断中的日志交错，主机不会读到半条；
+ * 代价是最长关中断时间等于最长一条日志的格式化时间，随字符数与数值参数个数增长（M0+ 无硬件除法，%d 逐位做软件除法），
+ * 可用 sl_latency 的 timer 延迟直方图观察。对中断延迟敏感时置 0：经 SEGGER_RTT_vprintf 分段拷贝，
+ * 每次关中断只写入 SEGGER_RTT_PRINTF_BUFFER_SIZE（64）字节。异步日志在主循环中格式化，不受此项影响 */
+#define SL_LOG_ZERO_COPY 1
+
+/* RTT 变量遥测通道（通道2）缓冲区大小，0 为不启用 */
+#define SL_RTT_TELE_SIZE 0
+
+/* RTT 变量遥测通道满时的处理 */
+#define SL_RTT_TELE_MODE SEGGER_RTT_MODE_NO_BLOCK_SKIP
+
+/* 编译期日志等级 SL_LEVEL_NONE/ERROR/WARN/INFO/DEBUG，低于此等级的日志调用连同字符串一并移除 */
+#define SL_LOG_LEVEL SL_LEVEL_DEBUG
+
+/* 运行期默认日志等级，可用 sl_log_set_level 按模块调高 */
+#define SL_LOG_LEVEL_RUNTIME SL_LEVEL_INFO
+
+/* 日志模块，用户可追加，源文件在包含 sloop.h 之前定义 SL_LOG_MODULE 选择模块，默认 SL_MOD_APP */
+#define SL_MOD_KERNEL 0
+#define SL_MOD_FLOW 1
+#define SL_MOD_APP 2
+
+/* 日志模块数 */
+#define SL_MOD_NUM 3
+
+/* 去重打印的时间窗口 ms */
+#define SL_LOG_DEDUP_MS 1000
+
+/* 二进制日志：只发送格式描述符地址与原始参数，由主机端 tools/sl_log.py 还原文本 */
+#define SL_LOG_BINARY 0
+
+/* 异步日志：打印只写入 RAM 暂存队列，由并行任务在主循环中格式化/拷贝到 RTT，
+ * 文本模式每条至多渲染 8 个参数，超出的转换说明符输出为 ? */
+#define SL_LOG_ASYNC 0
+
+/* 异步日志线程模式暂存队列字节数，须为2的幂 */
+#define SL_LOG_QUEUE_SIZE 512
+
+/* 异步日志每个中断优先级（以及 HardFault、NMI）的暂存队列字节数，须为2的幂，中断中打印无需关中断 */
+#define SL_LOG_ISR_QUEUE_SIZE 128
+
+/* 异步日志时可置 1：RTT 只在主循环中写入，去掉 RTT 写入时的关中断（中断中不得直接调用 SEGGER_RTT_xxx） */
+#define SL_LOG_RTT_LOCKLESS 0
+
+/* 每轮主循环最多输出的异步日志条数 */
+#define SL_LOG_DRAIN_NUM 2
+
+/* 单条二进制/异步日志最大字节数（含 9 字节帧头，不大于 264），超出部分截断 */
+#define SL_LOG_FRAME_SIZE 64
+
+/* 日志输出后端：SL_BACKEND_RTT 由 J-Link 读取；SL_BACKEND_UART 将 RTT 通道0的数据经 UART+DMA 发出（可由编译选项指定） */
+#ifndef SL_LOG_BACKEND
+#define SL_LOG_BACKEND SL_BACKEND_RTT
+#endif
+
+/* UART 后端波特率 */
+#define SL_LOG_UART_BAUD 115200
+
+/* UART 后端 DMA 双缓冲，每块字节数 */
+#define SL_LOG_UART_BUF_SIZE 128
+
+/* UART 后端主机测试桩：不访问硬件，发送内容交给 sl_log_uart_sink，按波特率模拟 DMA 耗时（可由编译选项指定） */
+#ifndef SL_LOG_UART_STUB
+#define SL_LOG_UART_STUB 0
+#endif
+
+/* ============================================================== */
+
+/* 启用 Flow 状态迁移跟踪，经 RTT 通道1输出 */
+#define SL_TRACE_ENABLE 0
+
+/* 跟踪 RAM 环形缓冲记录数，须为2的幂，每条 16 字节 */
+#define SL_TRACE_NUM 64
+
+/* 跟踪 RTT 通道缓冲区大小 */
+#define SL_TRACE_RTT_SIZE 512
+
+/* 跟踪 RTT 通道满时的处理 */
+#define SL_TRACE_RTT_MODE SEGGER_RTT_MODE_NO_BLOCK_SKIP
+
+/* ============================================================== */
+
+/* 启用变量示波：tick 中断中采样已登记变量，经 RTT 通道2输出，需 SL_RTT_TELE_SIZE 大于 0 */
+#define SL_SCOPE_ENABLE 0
+
+/* 可登记的示波变量数 */
+#define SL_SCOPE_VAR_LIMIT 8
+
 #endif /* __sl_config_H */
 
 /************************** END OF FILE **************************/
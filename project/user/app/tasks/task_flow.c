@@ -12,8 +12,6 @@
 FLOW_EVENT_DEFINE(evt_order);
 /* 外卖送达事件 */
 FLOW_EVENT_DEFINE(evt_arrive);
-/* 用餐完成事件 */
-FLOW_EVENT_DEFINE(evt_eat);
 
 FLOW_STATE_DEFINE(flow_user);
 FLOW_STATE_DEFINE(flow_delivery);
@@ -48,6 +46,9 @@ void flow_user(void)
     /* 工作流上下文，工作流需要的数据在此静态定义 */
     SL_FLOW_CONTEXT(flow_user);
 
+    /* 用餐结果 */
+    static int eat_status;
+
     /* 初次进入工作流，执行一次，初始化工作流上下文 */
     SL_FLOW_INIT;
     sl_printf("user: Open food delivery APP");
@@ -56,9 +57,6 @@ void flow_user(void)
     SL_FLOW_FREE(flow_user);
     sl_printf("user: Exit");
 
-    FLOW_STOP(flow_eat);
-    FLOW_STOP(flow_watch);
-
     /* 下方开始进入工作流运行逻辑 */
     SL_FLOW_RUN;
 
@@ -66,11 +64,13 @@ void flow_user(void)
     sl_printf("user: Place an order");
     FLOW_SEND_EVENT(evt_order);
 
-    FLOW_START(flow_eat);
-    FLOW_START(flow_watch);
+    /* 子 Flow 随 flow_user 一起停止，无需手动 FLOW_STOP */
+    FLOW_SPAWN(flow_watch);
 
     /* 等待用餐完成 */
-    FLOW_WAIT_EVENT(evt_eat);
+    FLOW_CALL(flow_eat, eat_status);
+
+    sl_printf("user: Eat finished, status %d", eat_status);
 
     /* 结束示例 */
     sl_goto(task_idle);
@@ -137,6 +137,9 @@ void flow_eat(void)
     /* 工作流上下文，工作流需要的数据在此静态定义 */
     SL_FLOW_CONTEXT(flow_eat);
 
+    /* 外卖送达结果 */
+    static char arrived;
+
     /* 初次进入工作流，执行一次，初始化工作流上下文 */
     SL_FLOW_INIT;
     sl_printf("eat: Preparing");
@@ -148,16 +151,21 @@ void flow_eat(void)
     /* 下方开始进入工作流运行逻辑 */
     SL_FLOW_RUN;
 
-    /* 等待外卖送达 */
-    FLOW_WAIT_EVENT(evt_arrive);
+    /* 等待外卖送达，超时取消 */
+    FLOW_WAIT_EVENT_TIMEOUT(evt_arrive, 10000, arrived);
+
+    if (arrived == FLOW_TIMEOUT)
+    {
+        sl_printf("eat: Delivery timeout, cancel");
+
+        FLOW_RETURN(1);
+    }
 
     sl_printf("eat: Takeaway arrived, start eating");
 
     FLOW_WAIT(2000);
     sl_printf("eat: Finished eating");
 
-    FLOW_SEND_EVENT(evt_eat);
-
     FLOW_EXIT();
 
     SL_FLOW_END;
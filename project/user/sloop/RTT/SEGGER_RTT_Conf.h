@@ -82,7 +82,7 @@ Revision: $Rev: 24316 $
 // Up-channel 1: SystemView
 //
 #ifndef   SEGGER_RTT_MAX_NUM_UP_BUFFERS
-  #define SEGGER_RTT_MAX_NUM_UP_BUFFERS             (1)     // Max. number of up-buffers (T->H) available on this target    (Default: 3)
+  #define SEGGER_RTT_MAX_NUM_UP_BUFFERS             (SL_RTT_TELE_SIZE ? 3 : 1 + SL_TRACE_ENABLE)     // Max. number of up-buffers (T->H) available on this target: 0 text, 1 trace, 2 telemetry    (Default: 3)
 #endif
 //
 // Most common case:
@@ -106,7 +106,7 @@ Revision: $Rev: 24316 $
 #endif
 
 #ifndef   SEGGER_RTT_MODE_DEFAULT
-  #define SEGGER_RTT_MODE_DEFAULT                   SEGGER_RTT_MODE_NO_BLOCK_SKIP // Mode for pre-initialized terminal channel (buffer 0)
+  #define SEGGER_RTT_MODE_DEFAULT                   SL_RTT_TEXT_MODE // Mode for pre-initialized terminal channel (buffer 0)
 #endif
 
 /*********************************************************************
@@ -154,8 +154,17 @@ Revision: $Rev: 24316 $
 *       RTT lock configuration for SEGGER Embedded Studio,
 *       Rowley CrossStudio and GCC
 */
-#if ((defined(__SES_ARM) || defined(__SES_RISCV) || defined(__CROSSWORKS_ARM) || defined(__GNUC__) || defined(__clang__)) && !defined (__CC_ARM) && !defined(WIN32))
-  #if (defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_8M_BASE__))
+#if ((defined(__SES_ARM) || defined(__SES_RISCV) || defined(__CROSSWORKS_ARM) || defined(__GNUC__) || defined(__clang__)) && !defined (__CC_ARM) && !defined(WIN32)) && !SL_LOG_RTT_LOCKLESS
+  #if defined(SL_PORT_HOST)
+    // sloop host port: tick runs as a signal on the main thread, see port/posix/sl_port_posix.c
+    unsigned sl_port_irq_save(void);
+    void sl_port_irq_restore(unsigned state);
+    #define SEGGER_RTT_LOCK()   {                                                                   \
+                                  unsigned _SEGGER_RTT__LockState = sl_port_irq_save();
+
+    #define SEGGER_RTT_UNLOCK()   sl_port_irq_restore(_SEGGER_RTT__LockState);                      \
+                                }
+  #elif (defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_8M_BASE__))
     #define SEGGER_RTT_LOCK()   {                                                                   \
                                     unsigned int _SEGGER_RTT__LockState;                                         \
                                   __asm volatile ("mrs   %0, primask  \n\t"                         \
@@ -328,7 +337,7 @@ Revision: $Rev: 24316 $
 *
 *       RTT lock configuration for KEIL ARM
 */
-#ifdef __CC_ARM
+#if defined(__CC_ARM) && !SL_LOG_RTT_LOCKLESS
   #if (defined __TARGET_ARCH_6S_M)
     #define SEGGER_RTT_LOCK()   {                                                                   \
                                   unsigned int _SEGGER_RTT__LockState;                                           \
@@ -0,0 +1,470 @@
+/**
+ ******************************************************************************
+ * @file    sl_bench
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   调度器微基准：按注册表填充程度测量各调度操作的周期数，以 JSON 经 RTT 通道0输出
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+/*
+ * 注册表都是定长数组线性扫描，操作耗时随已登记的项数增长。这里对每种操作、每个填充程度
+ * f = 1 ~ SL_xxx_LIMIT（操作完成后注册表中的项数）重复测量 BENCH_REPS 次，扣除 sl_get_cycle
+ * 自身开销后输出最小值与中位数，中位数不受偶发的 tick 中断影响。
+ *
+ * 须在注册表为空时运行：目标板上由 sloop_init 在登记系统任务前调用（SL_BENCH_ENABLE），
+ * 主机上由 sloop_bench 直接调用。tick 中断照常投递 soft_timer，单次任务注册表中的第一项
+ * 即为 soft_timer，与实际运行时一致。运行结束后注册表恢复为空，注册表峰值恢复为运行前的值。
+ *
+ * 结果格式：
+ * {"bench": "sloop", "cycles_per_ms": 64000, "reps": 32, "overhead": 40, "ramfunc_bytes": 0,
+ *  "ops": {"timeout_start": [{"fill": 1, "min": 30, "med": 32}, ...], ...},
+ *  "dropped": 0}
+ * dropped 为等待 RTT 空间超时而丢弃的行数，不为 0 时结果不完整
+ */
+
+/* 每个填充程度的测量次数 */
+#define BENCH_REPS 32
+
+/* 不会到期的定时器时长 ms */
+#define BENCH_FAR_MS 1000000
+
+/* 输出一行前等待 RTT 缓冲区空间的最长时间 ms，无主机读取时超时丢弃，不阻塞启动 */
+#define BENCH_WAIT_MS 100
+
+/* 单行最大字节数 */
+#define BENCH_LINE 64
+
+/* 空任务数，须不小于各注册表容量 */
+#define BENCH_DUMMY_NUM 32
+
+#if SL_TIMEOUT_LIMIT > BENCH_DUMMY_NUM || SL_CYCLE_LIMIT > BENCH_DUMMY_NUM || SL_MULTIPLE_LIMIT > BENCH_DUMMY_NUM || \
+    SL_PARALLEL_LIMIT > BENCH_DUMMY_NUM || SL_ONCE_LIMIT > BENCH_DUMMY_NUM
+#error "sl_bench: registry limit exceeds BENCH_DUMMY_NUM"
+#endif
+
+/* 软件定时器 */
+void soft_timer(void);
+/* 并行任务运行 */
+void parallel_task_run(void);
+/* 单次任务运行 */
+void once_task_run(void);
+/* 清空负载任务统计表，见 sl_load.c */
+void sl_load_task_clear(void);
+
+/* 一轮并行任务。虚拟时间仿真中标记为有进展：测量中的轮次不推进 tick，注册表为空时也不会因无到期时刻而结束 */
+#define bench_round()         \
+    do                        \
+    {                         \
+        sl_sim_busy();        \
+        parallel_task_run();  \
+    } while (0)
+
+/* ============================================================== */
+
+/* 注册表按函数地址去重，每个空任务须有不同地址，函数体各不相同以免被编译器合并 */
+static volatile int bench_sink;
+
+#define BENCH_DUMMY(n) \
+    static void bench_dummy_##n(void) { bench_sink = n; }
+
+BENCH_DUMMY(0) BENCH_DUMMY(1) BENCH_DUMMY(2) BENCH_DUMMY(3) BENCH_DUMMY(4) BENCH_DUMMY(5) BENCH_DUMMY(6) BENCH_DUMMY(7)
+BENCH_DUMMY(8) BENCH_DUMMY(9) BENCH_DUMMY(10) BENCH_DUMMY(11) BENCH_DUMMY(12) BENCH_DUMMY(13) BENCH_DUMMY(14) BENCH_DUMMY(15)
+BENCH_DUMMY(16) BENCH_DUMMY(17) BENCH_DUMMY(18) BENCH_DUMMY(19) BENCH_DUMMY(20) BENCH_DUMMY(21) BENCH_DUMMY(22) BENCH_DUMMY(23)
+BENCH_DUMMY(24) BENCH_DUMMY(25) BENCH_DUMMY(26) BENCH_DUMMY(27) BENCH_DUMMY(28) BENCH_DUMMY(29) BENCH_DUMMY(30) BENCH_DUMMY(31)
+
+static const pfunc bench_dummy[BENCH_DUMMY_NUM] = {
+    bench_dummy_0, bench_dummy_1, bench_dummy_2, bench_dummy_3, bench_dummy_4, bench_dummy_5, bench_dummy_6, bench_dummy_7,
+    bench_dummy_8, bench_dummy_9, bench_dummy_10, bench_dummy_11, bench_dummy_12, bench_dummy_13, bench_dummy_14, bench_dummy_15,
+    bench_dummy_16, bench_dummy_17, bench_dummy_18, bench_dummy_19, bench_dummy_20, bench_dummy_21, bench_dummy_22, bench_dummy_23,
+    bench_dummy_24, bench_dummy_25, bench_dummy_26, bench_dummy_27, bench_dummy_28, bench_dummy_29, bench_dummy_30, bench_dummy_31,
+};
+
+/* Flow 恢复测量用的 Flow 与条件 */
+FLOW_STATE_DEFINE(bench_flow);
+
+static char bench_flag;
+
+void bench_flow(void)
+{
+    SL_FLOW_CONTEXT(bench_flow);
+
+    SL_FLOW_INIT;
+
+    SL_FLOW_FREE(bench_flow);
+
+    SL_FLOW_RUN;
+
+    FLOW_UNTIL(bench_flag);
+
+    bench_flag = 0;
+
+    SL_FLOW_END;
+}
+
+/* ============================================================== */
+
+/* 各操作的一次测量：准备 f 项的注册表，只计时被测操作本身，结束后清空注册表，返回周期数 */
+
+static uint32_t bench_timeout_start(int f)
+{
+    for (int i = 0; i < f - 1; i++)
+        sl_timeout_start(BENCH_FAR_MS, bench_dummy[i]);
+
+    uint32_t t = sl_get_cycle();
+
+    sl_timeout_start(BENCH_FAR_MS, bench_dummy[f - 1]);
+
+    t = sl_get_cycle() - t;
+
+    for (int i = 0; i < f; i++)
+        sl_timeout_stop(bench_dummy[i]);
+
+    return t;
+}
+
+static uint32_t bench_timeout_stop(int f)
+{
+    for (int i = 0; i < f; i++)
+        sl_timeout_start(BENCH_FAR_MS, bench_dummy[i]);
+
+    uint32_t t = sl_get_cycle();
+
+    sl_timeout_stop(bench_dummy[f - 1]);
+
+    t = sl_get_cycle() - t;
+
+    for (int i = 0; i < f - 1; i++)
+        sl_timeout_stop(bench_dummy[i]);
+
+    return t;
+}
+
+/* 含登记时立即执行的一次空任务 */
+static uint32_t bench_cycle_start(int f)
+{
+    for (int i = 0; i < f - 1; i++)
+        sl_cycle_start(BENCH_FAR_MS, bench_dummy[i]);
+
+    uint32_t t = sl_get_cycle();
+
+    sl_cycle_start(BENCH_FAR_MS, bench_dummy[f - 1]);
+
+    t = sl_get_cycle() - t;
+
+    for (int i = 0; i < f; i++)
+        sl_cycle_stop(bench_dummy[i]);
+
+    return t;
+}
+
+static uint32_t bench_task_start(int f)
+{
+    for (int i = 0; i < f - 1; i++)
+        sl_task_start(bench_dummy[i]);
+
+    uint32_t t = sl_get_cycle();
+
+    sl_task_start(bench_dummy[f - 1]);
+
+    t = sl_get_cycle() - t;
+
+    for (int i = 0; i < f; i++)
+        sl_task_stop(bench_dummy[i]);
+
+    return t;
+}
+
+/* 关中断模拟中断上下文。第一项为 soft_timer：f 为 1 时即 tick 中断向空注册表投递 soft_timer */
+static uint32_t bench_task_once(int f)
+{
+    pfunc task = soft_timer;
+
+    __disable_irq();
+
+    if (f > 1)
+    {
+        sl_task_once(soft_timer);
+
+        for (int i = 0; i < f - 2; i++)
+            sl_task_once(bench_dummy[i]);
+
+        task = bench_dummy[f - 2];
+    }
+
+    uint32_t t = sl_get_cycle();
+
+    sl_task_once(task);
+
+    t = sl_get_cycle() - t;
+
+    __enable_irq();
+
+    /* 运行并清空单次任务注册表 */
+    once_task_run();
+
+    return t;
+}
+
+/* 超时、周期、多次任务注册表各登记 f 项（不超过各自容量），due 为 1 时全部到期并调用 */
+static uint32_t bench_soft_timer(int f, char due)
+{
+    int ms = due ? 0 : BENCH_FAR_MS;
+
+    for (int i = 0; i < f && i < SL_TIMEOUT_LIMIT; i++)
+        sl_timeout_start(ms, bench_dummy[i]);
+
+    for (int i = 0; i < f && i < SL_CYCLE_LIMIT; i++)
+        sl_cycle_start(ms, bench_dummy[i]);
+
+    for (int i = 0; i < f && i < SL_MULTIPLE_LIMIT; i++)
+        sl_multiple_start(2, ms, bench_dummy[i]);
+
+    uint32_t t = sl_get_cycle();
+
+    soft_timer();
+
+    t = sl_get_cycle() - t;
+
+    for (int i = 0; i < f; i++)
+    {
+        sl_timeout_stop(bench_dummy[i]);
+
+        sl_cycle_stop(bench_dummy[i]);
+
+        sl_multiple_stop(bench_dummy[i]);
+    }
+
+    return t;
+}
+
+static uint32_t bench_soft_timer_idle(int f)
+{
+    return bench_soft_timer(f, 0);
+}
+
+static uint32_t bench_soft_timer_due(int f)
+{
+    return bench_soft_timer(f, 1);
+}
+
+/* 一轮并行任务，f 个空任务 */
+static uint32_t bench_parallel(int f)
+{
+    for (int i = 0; i < f; i++)
+        sl_task_start(bench_dummy[i]);
+
+    uint32_t t = sl_get_cycle();
+
+    bench_round();
+
+    t = sl_get_cycle() - t;
+
+    for (int i = 0; i < f; i++)
+        sl_task_stop(bench_dummy[i]);
+
+    return t;
+}
+
+/* 一轮并行任务，其中一个 Flow 从 FLOW_UNTIL 挂起处恢复，其余 f-1 个为空任务。
+ * 与同一 f 下的 parallel_task_run 相减即为一次恢复的开销 */
+static uint32_t bench_flow_resume(int f)
+{
+    FLOW_START(bench_flow);
+
+    for (int i = 0; i < f - 1; i++)
+        sl_task_start(bench_dummy[i]);
+
+    /* 第一轮执行初始化区，第二轮在 FLOW_UNTIL 处挂起 */
+    bench_flag = 0;
+
+    bench_round();
+
+    bench_round();
+
+    bench_flag = 1;
+
+    uint32_t t = sl_get_cycle();
+
+    bench_round();
+
+    t = sl_get_cycle() - t;
+
+    /* 停止 Flow，下一轮执行清理区并撤销登记 */
+    FLOW_STOP(bench_flow);
+
+    bench_round();
+
+    for (int i = 0; i < f - 1; i++)
+        sl_task_stop(bench_dummy[i]);
+
+    return t;
+}
+
+/* ============================================================== */
+
+typedef struct
+{
+    const char *name;
+
+    int limit;
+
+    uint32_t (*run)(int f);
+
+} bench_typ;
+
+#define BENCH_MAX3(a, b, c) ((a) > (b) ? ((a) > (c) ? (a) : (c)) : ((b) > (c) ? (b) : (c)))
+
+static const bench_typ bench_list[] = {
+    {"timeout_start", SL_TIMEOUT_LIMIT, bench_timeout_start},
+    {"timeout_stop", SL_TIMEOUT_LIMIT, bench_timeout_stop},
+    {"cycle_start", SL_CYCLE_LIMIT, bench_cycle_start},
+    {"task_start", SL_PARALLEL_LIMIT, bench_task_start},
+    {"task_once_isr", SL_ONCE_LIMIT, bench_task_once},
+    {"soft_timer_idle", BENCH_MAX3(SL_TIMEOUT_LIMIT, SL_CYCLE_LIMIT, SL_MULTIPLE_LIMIT), bench_soft_timer_idle},
+    {"soft_timer_due", BENCH_MAX3(SL_TIMEOUT_LIMIT, SL_CYCLE_LIMIT, SL_MULTIPLE_LIMIT), bench_soft_timer_due},
+    {"parallel_task_run", SL_PARALLEL_LIMIT, bench_parallel},
+    {"flow_resume", SL_PARALLEL_LIMIT, bench_flow_resume},
+};
+
+#define BENCH_NUM (int)(sizeof bench_list / sizeof bench_list[0])
+
+/* 测量样本，升序排列后取最小值与中位数 */
+static uint32_t bench_sample[BENCH_REPS];
+
+/* 丢弃的行数 */
+static uint32_t bench_dropped;
+
+/* 插入排序 */
+static void bench_sort(void)
+{
+    for (int i = 1; i < BENCH_REPS; i++)
+    {
+        uint32_t v = bench_sample[i];
+
+        int j = i;
+
+        for (; j > 0 && bench_sample[j - 1] > v; j--)
+            bench_sample[j] = bench_sample[j - 1];
+
+        bench_sample[j] = v;
+    }
+}
+
+/* 等待 RTT 缓冲区有一整行的空间，超时返回 0，该行丢弃并计数 */
+static char bench_room(void)
+{
+#if SL_RTT_ENABLE
+    uint32_t start = sl_get_tick();
+
+    while (SEGGER_RTT_GetAvailWriteSpace(SL_RTT_CH_TEXT) < BENCH_LINE)
+    {
+        if (sl_get_tick() - start >= BENCH_WAIT_MS)
+        {
+            bench_dropped++;
+
+            return 0;
+        }
+
+#if defined(SL_PORT_HOST)
+        /* 主机上直接读出，不等输出线程 */
+        sl_port_host_flush();
+#endif
+
+#if defined(SL_PORT_SIM) && !defined(SL_PORT_FLEET)
+        /* 虚拟时间在忙等中不会前进，每次推进 1ms，读不出时（如 UART 后端）仍会超时 */
+        sl_sim_work(SysTick->LOAD + 1);
+#endif
+    }
+#endif
+
+    return 1;
+}
+
+/* 输出一行 JSON */
+#define bench_out(sFormat, ...)                                    \
+    do                                                             \
+    {                                                              \
+        if (bench_room())                                          \
+            sl_rtt_printf(SL_RTT_CH_TEXT, sFormat, ##__VA_ARGS__); \
+    } while (0)
+
+/* 测量 sl_get_cycle 连续调用的开销，从各样本中扣除 */
+static uint32_t bench_overhead(void)
+{
+    for (int r = 0; r < BENCH_REPS; r++)
+    {
+        uint32_t t = sl_get_cycle();
+
+        bench_sample[r] = sl_get_cycle() - t;
+    }
+
+    bench_sort();
+
+    return bench_sample[BENCH_REPS / 2];
+}
+
+/* ============================================================== */
+
+/* 运行全部微基准，须在 sloop_init 登记系统任务之前调用 */
+void sl_bench_run(void)
+{
+    /* 测量会把各注册表填满，结束后恢复峰值统计 */
+    sl_mem_typ mem = sl_mem;
+
+    uint32_t overhead = bench_overhead();
+
+    /* 清空 tick 中断此前投递的 soft_timer */
+    once_task_run();
+
+    bench_dropped = 0;
+
+    bench_out("{\"bench\": \"sloop\", \"cycles_per_ms\": %u, \"reps\": %u, \"overhead\": %u,\n",
+              SysTick->LOAD + 1, BENCH_REPS, overhead);
+
+    /* 调度热路径在 SRAM 中执行时占用的字节数，用于对比 SL_RAMFUNC_ENABLE 的收益与代价 */
+    bench_out("\"ramfunc_bytes\": %u,\n", sl_ramfunc_size());
+
+    bench_out("\"ops\": {\n");
+
+    for (int b = 0; b < BENCH_NUM; b++)
+    {
+        const bench_typ *p = &bench_list[b];
+
+        bench_out("\"%s\": [\n", p->name);
+
+        for (int f = 1; f <= p->limit; f++)
+        {
+            for (int r = 0; r < BENCH_REPS; r++)
+            {
+                uint32_t t = p->run(f);
+
+                bench_sample[r] = t > overhead ? t - overhead : 0;
+            }
+
+            bench_sort();
+
+            bench_out(f < p->limit ? "{\"fill\": %u, \"min\": %u, \"med\": %u},\n" : "{\"fill\": %u, \"min\": %u, \"med\": %u}\n",
+                      f, bench_sample[0], bench_sample[BENCH_REPS / 2]);
+        }
+
+        bench_out(b < BENCH_NUM - 1 ? "],\n" : "]\n");
+    }
+
+    bench_out("},\n");
+
+    /* 本行自身丢弃时 JSON 不完整，主机端同样能发现 */
+    bench_out("\"dropped\": %u}\n", bench_dropped);
+
+    sl_mem = mem;
+
+    /* 测量用的任务不留在负载统计表中 */
+    sl_load_task_clear();
+}
+
+/************************** END OF FILE **************************/
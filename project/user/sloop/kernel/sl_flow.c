@@ -0,0 +1,158 @@
+/**
+ ******************************************************************************
+ * @file    sl_flow
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   Flow 运行时服务：多路等待、通道、层级 Flow
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_FLOW
+
+#include "sloop.h"
+
+/* 事件/通道发送计数 */
+volatile uint32_t flow_signal;
+
+/* ============================================================== */
+
+/* 检查等待源，返回首个就绪源序号（从1开始），均未就绪返回 FLOW_TIMEOUT */
+int flow_select(flow_src_typ *src, int num)
+{
+    for (int i = 0; i < num; i++)
+    {
+        if (*src[i].ready == 0)
+            continue;
+
+        /* 事件为消费型，选中即清除 */
+        if (src[i].consume)
+            *src[i].ready = 0;
+
+        return i + 1;
+    }
+
+    return FLOW_TIMEOUT;
+}
+
+/* ============================================================== */
+
+/* 通道发送 */
+char flow_chan_send(flow_chan_typ *chan, uint32_t msg)
+{
+    __disable_irq();
+
+    if (chan->count >= chan->size)
+    {
+        __enable_irq();
+
+        return 0;
+    }
+
+    chan->buf[chan->tail] = msg;
+
+    sl_add(chan->tail, chan->size - 1);
+
+    chan->count++;
+
+    __enable_irq();
+
+    flow_signal++;
+
+    return 1;
+}
+
+/* 通道接收 */
+char flow_chan_recv(flow_chan_typ *chan, uint32_t *msg)
+{
+    if (chan->count == 0)
+        return 0;
+
+    __disable_irq();
+
+    *msg = chan->buf[chan->head];
+
+    sl_add(chan->head, chan->size - 1);
+
+    chan->count--;
+
+    __enable_irq();
+
+    return 1;
+}
+
+/* ============================================================== */
+
+/* 父子 Flow 挂接关系，以 Flow 状态变量地址作为标识 */
+typedef struct
+{
+    uint32_t *parent;
+
+    uint32_t *child;
+
+} flow_child_typ;
+
+/* 子 Flow 注册表 */
+static flow_child_typ child_reg[SL_FLOW_CHILD_LIMIT];
+
+/* 挂接子 Flow */
+void flow_link(uint32_t *parent, uint32_t *child)
+{
+    for (int i = 0; i < SL_FLOW_CHILD_LIMIT; i++)
+    {
+        if (child_reg[i].child == child)
+        {
+            /* 已挂接，更新父 Flow */
+            child_reg[i].parent = parent;
+
+            return;
+        }
+    }
+
+    for (int i = 0; i < SL_FLOW_CHILD_LIMIT; i++)
+    {
+        if (child_reg[i].child == NULL)
+        {
+            child_reg[i].parent = parent;
+
+            child_reg[i].child = child;
+
+            sl_mem_peak(flow_child, i);
+
+            return;
+        }
+    }
+
+    sl_error("flow child overflow, limit %2d", SL_FLOW_CHILD_LIMIT);
+}
+
+/* Flow 退出：解除自身挂接，并停止全部子 Flow（子 Flow 退出时再逐级停止孙 Flow） */
+void flow_release(uint32_t *flow)
+{
+    /* 退出信号量等待队列，释放持有的互斥量 */
+    sl_sem_drop(flow);
+
+    for (int i = 0; i < SL_FLOW_CHILD_LIMIT; i++)
+    {
+        if (child_reg[i].child == NULL)
+            continue;
+
+        if (child_reg[i].child == flow)
+        {
+            child_reg[i].child = NULL;
+
+            continue;
+        }
+
+        if (child_reg[i].parent == flow)
+        {
+            /* 等同 FLOW_STOP，子 Flow 在下一轮执行清理区 */
+            if (*child_reg[i].child != FLOW_EXITED)
+                *child_reg[i].child = FLOW_FREE;
+
+            child_reg[i].child = NULL;
+        }
+    }
+}
+
+/************************** END OF FILE **************************/
@@ -0,0 +1,210 @@
+/**
+ ******************************************************************************
+ * @file    sl_gov
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   按 CPU 负载调频：低负载时逐档降低 HCLK 以省电，负载升高时直接回到全速
+ *          每次切换后重新校准 SysTick、周期计数、负载基线、跟踪时间戳与日志串口波特率
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+#if SL_GOV_ENABLE
+
+/*
+ * 每个负载统计窗口（100ms）结束时由 sl_load.c 调用 sl_gov_update：
+ * 负载高于 SL_GOV_UP 立即回到全速；持续 SL_GOV_HOLD_MS 低于 SL_GOV_DOWN 则降一档（HCLK 减半），
+ * 降档后负载约翻倍，仍低于 SL_GOV_UP，两个阈值之间不会来回切换。
+ *
+ * 只改变 AHB 分频，PLL 与 SYSCLK 不动，切换在数 us 内完成。切换在关中断下进行：
+ * 记下切换前的周期计数与本 ms 内已走过的 SysTick 比例，以新频率重启 SysTick 后恢复同样的比例，
+ * 下一次 tick 仍在原来的时刻到达，tick 不丢失也不重复；临近 tick 或 tick 已挂起时本次不切换，下个窗口再试。
+ * 周期计数保持连续，负载统计窗口重新开始，空转基线按新时钟重新学习。
+ *
+ * 定时器、SPI 等以 HCLK/PCLK 为时钟的外设由用户在 sl_gov_notify 中重新配置，
+ * 其工作期间可调用 sl_gov_full(1) 保持全速。
+ */
+
+/* 当前档位，第 n 档 HCLK 为全速的 1/2^n */
+static int gov_level;
+
+/* 低负载开始的时刻 */
+static uint32_t gov_low;
+
+/* 保持全速 */
+static char gov_full;
+
+/* 周期计数连续，见 sloop.c */
+void sl_cycle_rebase(uint32_t before);
+/* 负载统计按新时钟重新开始 */
+void sl_load_clock(void);
+/* 跟踪写入新的时间戳换算头记录 */
+void sl_trace_clock(void);
+/* UART 日志后端发送空闲 / 重新设置波特率 */
+char sl_log_uart_idle(void);
+void sl_log_uart_clock(void);
+
+/* ============================================================== */
+
+/* 以 G0 为例：只改 AHB 分频，按 HCLK 设置 flash 等待周期，再恢复 SysTick 相位 */
+sl_weak char sl_gov_clock(uint32_t div)
+{
+#if !defined(SL_PORT_HOST)
+    static const uint32_t hpre[] = {RCC_SYSCLK_DIV1, RCC_SYSCLK_DIV2, RCC_SYSCLK_DIV4, RCC_SYSCLK_DIV8, RCC_SYSCLK_DIV16};
+
+    int i = 0;
+
+    while ((1u << i) < div && i < 4)
+        i++;
+
+    uint32_t load = SysTick->LOAD;
+
+    uint32_t val = SysTick->VAL;
+
+    /* 本 ms 已过 3/4 或 tick 已挂起，重启 SysTick 可能丢失 tick */
+    if (val < (load + 1) / 4 || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+        return 0;
+
+    uint32_t hclk = HAL_RCC_GetSysClockFreq() >> i;
+
+    RCC_ClkInitTypeDef clk = {0};
+
+    clk.ClockType = RCC_CLOCKTYPE_HCLK;
+
+    clk.AHBCLKDivider = hpre[i];
+
+    /* flash 等待周期：24MHz 以下 0，48MHz 以下 1，否则 2 */
+    uint32_t latency = hclk > 48000000 ? FLASH_LATENCY_2 : hclk > 24000000 ? FLASH_LATENCY_1 : FLASH_LATENCY_0;
+
+    /* HAL 更新 SystemCoreClock，并以新频率重启 SysTick，计数从头开始 */
+    if (HAL_RCC_ClockConfig(&clk, latency) != HAL_OK)
+        return 0;
+
+    uint32_t full = SysTick->LOAD + 1;
+
+    /* 本 ms 内已走过的计数，按新频率换算，切换本身的耗时计入重启后的计数 */
+    uint32_t done = (uint64_t)(load - val) * full / (load + 1) + (SysTick->LOAD - SysTick->VAL);
+
+    if (done > full - 2)
+        done = full - 2;
+
+    /* 先以剩余计数重装一次，计数开始后恢复每 ms 计数，tick 相位不变 */
+    SysTick->LOAD = full - 1 - done;
+
+    SysTick->VAL = 0;
+
+    while (SysTick->VAL == 0)
+        ;
+
+    SysTick->LOAD = full - 1;
+
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/* 时钟切换后调用，以 HCLK/PCLK 为时钟的外设在此重新配置 */
+sl_weak void sl_gov_notify(uint32_t hclk) {}
+
+/* 切换到指定档位，不切换返回 0 */
+static char gov_switch(int level)
+{
+    char ok = 0;
+
+    __disable_irq();
+
+#if SL_RTT_ENABLE && SL_LOG_BACKEND == SL_BACKEND_UART
+    /* 串口发送中改变波特率会发出乱码 */
+    if (sl_log_uart_idle())
+#endif
+    {
+        uint32_t before = sl_get_cycle();
+
+        ok = sl_gov_clock(1u << level);
+
+        if (ok)
+        {
+            sl_cycle_rebase(before);
+
+#if SL_RTT_ENABLE && SL_LOG_BACKEND == SL_BACKEND_UART
+            sl_log_uart_clock();
+#endif
+        }
+    }
+
+    __enable_irq();
+
+    if (ok == 0)
+        return 0;
+
+    gov_level = level;
+
+    sl_load_clock();
+
+#if SL_TRACE_ENABLE
+    sl_trace_clock();
+#endif
+
+    sl_gov_notify(sl_gov_hclk());
+
+    sl_debug("hclk %d kHz", (int)(sl_gov_hclk() / 1000));
+
+    return 1;
+}
+
+/* 每个负载统计窗口结束时调用，load 单位 0.1% */
+void sl_gov_update(uint32_t load)
+{
+    uint32_t now = sl_get_tick();
+
+    /* 高负载或保持全速：回到全速，切换失败则下个窗口再试 */
+    if (gov_full || load > SL_GOV_UP)
+    {
+        gov_low = now;
+
+        if (gov_level > 0)
+            gov_switch(0);
+
+        return;
+    }
+
+    if (load >= SL_GOV_DOWN || gov_level >= SL_GOV_LEVELS - 1)
+    {
+        gov_low = now;
+
+        return;
+    }
+
+    if ((uint32_t)(now - gov_low) < SL_GOV_HOLD_MS)
+        return;
+
+    /* 降一档后重新计时 */
+    if (gov_switch(gov_level + 1))
+        gov_low = now;
+}
+
+/* 1：保持全速，0：恢复按负载调频 */
+void sl_gov_full(char on)
+{
+    gov_full = on;
+
+    gov_low = sl_get_tick();
+
+    if (on && gov_level > 0)
+        gov_switch(0);
+}
+
+/* 当前 HCLK Hz */
+uint32_t sl_gov_hclk(void)
+{
+    return (SysTick->LOAD + 1) * 1000;
+}
+
+#endif
+
+/************************** END OF FILE **************************/
@@ -0,0 +1,82 @@
+/**
+ ******************************************************************************
+ * @file    sl_hal
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   HAL 时基接管：HAL_GetTick/HAL_Delay 使用 sloop tick，HAL 内部的等待不再让整个系统停摆
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+#if SL_HAL_TICK_ENABLE && !defined(SL_PORT_HOST)
+
+/*
+ * HAL 默认在 SysTick_Handler 中另行累加 uwTick，HAL_Delay 与各驱动的超时循环空转等待，
+ * 一次 10ms 的 flash 或 I2C 超时期间 sloop 任务全部停摆。这里重新实现 HAL 的弱定义：
+ *
+ * HAL_IncTick 为空，SysTick_Handler 中的调用保留不动（CubeMX 重新生成不受影响），只由 sl_tick_irq 计时；
+ * HAL_GetTick 返回 sl_get_tick，同一段忙等待跨过 tick 后，每次调用让出一轮其他并行任务（sl_yield），
+ * 不足 1ms 的短等待（如 I2C 逐字节等待标志）不受影响；
+ * HAL_Delay 等待期间让出，无法让出时睡眠到下一个中断（SL_HAL_DELAY_SLEEP）。
+ *
+ * 让出时跳过调用者所在的并行任务，调用者不会重入；让出期间运行的任务再调用 HAL 等待时不再嵌套让出。
+ * 中断中、关中断时（如 sl_gov 切换时钟）不让出。让出期间其他任务访问同一外设时 HAL 句柄已上锁，返回 HAL_BUSY。
+ */
+
+/* 本段等待开始的 tick 与上次调用后的轮询轮数 */
+static uint32_t hal_start;
+static uint32_t hal_round;
+
+/* ============================================================== */
+
+/* tick 只由 sl_tick_irq 计数 */
+void HAL_IncTick(void) {}
+
+uint32_t HAL_GetTick(void)
+{
+    uint32_t now = sl_get_tick();
+
+    /* 中断中只取时间 */
+    if (__get_IPSR() != 0)
+        return now;
+
+    /* 上次调用以来回到过调度器，开始新的一段等待；
+     * 让出后仍返回让出前的时间，让出期间超过的超时留到下次调用，调用者先再检查一次标志 */
+    if (sl_get_round() != hal_round)
+        hal_start = now;
+    else if (now != hal_start)
+        sl_yield();
+
+    hal_round = sl_get_round();
+
+    return now;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    uint32_t start = sl_get_tick();
+
+    /* 与 HAL 一致，至少等待 1ms */
+    if (Delay < HAL_MAX_DELAY)
+        Delay++;
+
+    while ((uint32_t)(sl_get_tick() - start) < Delay)
+    {
+        if (sl_yield())
+            continue;
+
+#if SL_HAL_DELAY_SLEEP
+        /* 中断中或关中断时 tick 无法到达，与 HAL 一样空转 */
+        if (__get_IPSR() == 0 && __get_PRIMASK() == 0)
+            __WFI();
+#endif
+    }
+}
+
+#endif
+
+/************************** END OF FILE **************************/
@@ -0,0 +1,669 @@
+/**
+ ******************************************************************************
+ * @file    sl_load
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   CPU 负载统计：以周期计数时间戳测量空转之外的时间占比
+ *          给出当前、峰值、平均负载与各任务占比，以及主循环与软件定时器的延迟直方图
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+/*
+ * 主循环每轮都会轮询全部任务，没有可以睡眠的空闲点，这里把"一轮中所有任务都立即返回"作为空闲状态：
+ * 以周期计数测量相邻两轮的间隔，窗口内最短的一轮即空转一轮的开销（基线），超出基线的时间即为负载。
+ * 基线随时钟、编译选项与轮询内容自动变化，不依赖写死的常数；满载时窗口内可能没有空转的一轮，
+ * 因此基线每个窗口最多上调 1/16，避免把忙碌误判为空转。
+ *
+ * 各任务按自身执行时间（不含嵌套调用的任务）计算占比：每轮都轮询的并行/互斥任务同样减去
+ * 调用次数 × 单次空转开销；定时器回调与单次任务只在到期时调用，执行时间全部计为负载。
+ * 中断打断任务的时间计入被打断的任务，sl_wait 中的轮询计为空闲。
+ *
+ * 平均负载掩盖不了偶发的长轮次，延迟统计记录每轮间隔与 tick 到 soft_timer 运行的延迟的对数直方图，
+ * 给出最大值、p99 与最大值之前耗时最长的任务（需 SL_LOAD_TASK_NUM 不为 0）。
+ */
+
+/* 统计窗口 ms */
+#define LOAD_WINDOW 100
+
+#if SL_GOV_ENABLE
+/* 每个统计窗口结束时按负载调频 */
+void sl_gov_update(uint32_t load);
+#endif
+
+#if SL_SHED_ENABLE
+/* 每个统计窗口结束时按负载进入/退出过载降级 */
+void sl_shed_update(uint32_t load);
+#endif
+
+/* 窗口起点 */
+static uint32_t win_start;
+
+/* 上一轮开始时刻、窗口内轮数与最短一轮 */
+static uint32_t loop_last;
+static uint32_t loop_num;
+static uint32_t loop_min = UINT32_MAX;
+
+/* 空转一轮的开销 */
+static uint32_t loop_base;
+
+/* 窗口内主循环之外的空闲周期，见 sl_load_skip */
+static uint32_t loop_skip;
+
+/* 当前、峰值、平均负载 */
+static sl_load_typ load;
+
+/* 报告期内各窗口负载之和与窗口数 */
+static uint32_t report_sum;
+static uint32_t report_num;
+
+/* ============================================================== */
+
+/* 按窗口最短值更新基线，最多上调 1/16 */
+static uint32_t load_rebase(uint32_t base, uint32_t min)
+{
+    uint32_t limit = base + base / 16 + 1;
+
+    return (base == 0 || min < limit) ? min : limit;
+}
+
+/* ============================================================== */
+
+#if SL_LATENCY_ENABLE
+
+sl_latency_typ sl_latency;
+
+/* 本轮中耗时最长的任务 */
+static pfunc round_task;
+static uint32_t round_len;
+
+/* 上次 soft_timer 运行以来耗时最长的任务 */
+static pfunc timer_task;
+static uint32_t timer_len;
+
+/* 主循环已开始运行，此前的延迟包含初始化，不计入 */
+static char latency_started;
+
+/* soft_timer 投递时刻 */
+static volatile char timer_posted;
+static volatile uint32_t timer_post;
+
+/* 直方图桶号，即 log2(v) 取整，M0+ 没有 CLZ 指令，二分查找 */
+static sl_ramfunc int latency_bucket(uint32_t v)
+{
+    int i = 0;
+
+    if (v >= 1u << 16)
+    {
+        v >>= 16;
+        i += 16;
+    }
+
+    if (v >= 1u << 8)
+    {
+        v >>= 8;
+        i += 8;
+    }
+
+    if (v >= 1u << 4)
+    {
+        v >>= 4;
+        i += 4;
+    }
+
+    if (v >= 1u << 2)
+    {
+        v >>= 2;
+        i += 2;
+    }
+
+    if (v >= 1u << 1)
+        i += 1;
+
+    return (i < SL_LATENCY_BUCKETS) ? i : SL_LATENCY_BUCKETS - 1;
+}
+
+/* 样本数达到此值时各桶减半，主循环每秒百万轮时约 36 分钟一次 */
+#define LATENCY_HALVE (1u << 31)
+
+/* 各桶减半，计数不会溢出，百分位基本不变，旧样本的权重逐次减半 */
+static void latency_halve(sl_latency_hist_typ *h)
+{
+    h->count = 0;
+
+    for (int i = 0; i < SL_LATENCY_BUCKETS; i++)
+    {
+        h->hist[i] >>= 1;
+
+        h->count += h->hist[i];
+    }
+}
+
+/* 记录一次延迟 */
+static sl_ramfunc void latency_record(sl_latency_hist_typ *h, uint32_t v, pfunc culprit)
+{
+    h->hist[latency_bucket(v)]++;
+
+    if (++h->count >= LATENCY_HALVE)
+        latency_halve(h);
+
+    if (v > h->max)
+    {
+        h->max = v;
+
+        h->max_tick = sl_get_tick();
+
+        h->culprit = culprit;
+    }
+}
+
+/* 百分位所在桶的上界，超出它的样本不多于 count × above / 1000 */
+static uint32_t latency_pct(sl_latency_hist_typ *h, uint32_t above)
+{
+    uint32_t rest = (uint64_t)h->count * above / 1000;
+
+    for (int i = SL_LATENCY_BUCKETS - 1; i > 0; i--)
+    {
+        if (h->hist[i] > rest)
+            return 2u << i;
+
+        rest -= h->hist[i];
+    }
+
+    return 2;
+}
+
+/* tick 中断中投递 soft_timer 时调用，未运行前重复投递只记第一次 */
+sl_ramfunc void sl_latency_tick(void)
+{
+    if (timer_posted)
+        return;
+
+    timer_post = sl_get_cycle();
+
+    timer_posted = 1;
+}
+
+/* soft_timer 开始运行时调用 */
+sl_ramfunc void sl_latency_timer(void)
+{
+    uint32_t now = sl_get_cycle();
+
+    __disable_irq();
+
+    char posted = timer_posted;
+
+    uint32_t post = timer_post;
+
+    timer_posted = 0;
+
+    __enable_irq();
+
+    if (posted && latency_started)
+        latency_record(&sl_latency.timer, now - post, timer_task);
+
+    timer_task = NULL;
+
+    timer_len = 0;
+}
+
+/* 周期数向上取整到 us */
+#define latency_us(cycles, us) ((int)(((cycles) + (us) - 1) / (us)))
+
+/* 打印一项延迟统计，完整直方图可在调试器中查看 */
+static void latency_print(const char *name, sl_latency_hist_typ *h, uint32_t us)
+{
+    sl_printf("%s max %d us at %d ms, culprit 0x%p",
+              name, latency_us(h->max, us), (int)h->max_tick, (void *)h->culprit);
+
+    sl_printf("      p50 < %d us, p90 < %d us, p99 < %d us, p99.9 < %d us, %d samples",
+              latency_us(latency_pct(h, 500), us), latency_us(latency_pct(h, 100), us),
+              latency_us(latency_pct(h, 10), us), latency_us(latency_pct(h, 1), us), (int)h->count);
+}
+
+/* 打印主循环与软件定时器延迟的最大值、p99、肇事任务与直方图 */
+void sl_latency_report(void)
+{
+    uint32_t us = sl_latency.cycle_us ? sl_latency.cycle_us : 1;
+
+    latency_print("loop ", &sl_latency.loop, us);
+
+    latency_print("timer", &sl_latency.timer, us);
+}
+
+/* 清空延迟统计 */
+void sl_latency_reset(void)
+{
+    memset(&sl_latency.loop, 0, sizeof sl_latency.loop);
+
+    memset(&sl_latency.timer, 0, sizeof sl_latency.timer);
+}
+
+#endif
+
+/* ============================================================== */
+
+/* 每轮主循环调用一次（包括 sl_wait 中的轮询） */
+sl_ramfunc void sl_load_loop(void)
+{
+    uint32_t now = sl_get_cycle();
+
+    uint32_t dt = now - loop_last;
+
+    loop_last = now;
+
+    if (dt < loop_min)
+        loop_min = dt;
+
+    loop_num++;
+
+#if SL_LATENCY_ENABLE
+    if (latency_started)
+        latency_record(&sl_latency.loop, dt, round_task);
+
+    latency_started = 1;
+
+    round_task = NULL;
+
+    round_len = 0;
+#endif
+}
+
+/* 主循环之外经过的空闲周期（如虚拟时间仿真跳过的时间），计为空闲，不计入轮次间隔 */
+void sl_load_skip(uint32_t cycles)
+{
+    loop_last += cycles;
+
+    loop_skip += cycles;
+}
+
+/* ============================================================== */
+
+#if SL_LOAD_TASK_NUM
+
+/* 任务执行统计 */
+typedef struct
+{
+    pfunc task;
+
+    /* 窗口内自身执行周期、调用次数与单次最短周期 */
+    uint32_t cycles;
+    uint32_t calls;
+    uint32_t min;
+
+    /* 单次空转开销 */
+    uint32_t base;
+
+    /* 每轮都轮询的任务 */
+    char poll;
+
+    /* 报告期内运行过，未运行的表项在报告时回收 */
+    char used;
+
+    /* 报告期内各窗口占比之和 0.1% */
+    uint32_t sum;
+
+} load_task_typ;
+
+/* 任务统计表，按函数地址直接映射，冲突时顺延 */
+static load_task_typ load_task[SL_LOAD_TASK_NUM];
+
+/* 已结束的嵌套调用累计周期 */
+static uint32_t load_child;
+
+/* 任务在统计表中的起始位置 */
+#define load_home(task) (((uintptr_t)(task) >> 1) & (SL_LOAD_TASK_NUM - 1))
+
+/* 查找任务统计项，未登记则登记，表满返回 NULL（不单独统计） */
+static sl_ramfunc load_task_typ *load_find(pfunc task)
+{
+    int i = load_home(task);
+
+    for (int n = 0; n < SL_LOAD_TASK_NUM; n++)
+    {
+        load_task_typ *t = &load_task[i];
+
+        if (t->task == task)
+            return t;
+
+        if (t->task == NULL)
+        {
+            t->task = task;
+
+            t->min = UINT32_MAX;
+
+            return t;
+        }
+
+        sl_add(i, SL_LOAD_TASK_NUM - 1);
+    }
+
+    return NULL;
+}
+
+/* 任务调用前 */
+sl_ramfunc void sl_load_enter(sl_load_frame_typ *frame)
+{
+    frame->child = load_child;
+
+    frame->start = sl_get_cycle();
+}
+
+/* 任务调用后，task 为 NULL 时只从外层任务中扣除，不计入任何任务 */
+sl_ramfunc void sl_load_exit(sl_load_frame_typ *frame, pfunc task, char poll)
+{
+    uint32_t dt = sl_get_cycle() - frame->start;
+
+    /* 扣除嵌套调用的任务，得到自身执行时间 */
+    uint32_t self = dt - (load_child - frame->child);
+
+    load_child = frame->child + dt;
+
+    if (task == NULL)
+        return;
+
+#if SL_LATENCY_ENABLE
+    if (self > round_len)
+    {
+        round_len = self;
+
+        round_task = task;
+    }
+
+    if (self > timer_len)
+    {
+        timer_len = self;
+
+        timer_task = task;
+    }
+#endif
+
+    load_task_typ *t = load_find(task);
+
+    if (t == NULL)
+        return;
+
+    t->cycles += self;
+
+    t->calls++;
+
+    t->poll = poll;
+
+    if (self < t->min)
+        t->min = self;
+}
+
+/* 窗口结束，计算各任务占比 */
+static void load_task_window(uint32_t unit)
+{
+    for (int i = 0; i < SL_LOAD_TASK_NUM; i++)
+    {
+        load_task_typ *t = &load_task[i];
+
+        if (t->calls == 0)
+            continue;
+
+        t->used = 1;
+
+        uint32_t idle = 0;
+
+        if (t->poll)
+        {
+            t->base = load_rebase(t->base, t->min);
+
+            idle = t->calls * t->base;
+        }
+
+        if (t->cycles > idle)
+            t->sum += (t->cycles - idle) / unit;
+
+        t->cycles = 0;
+
+        t->calls = 0;
+
+        t->min = UINT32_MAX;
+    }
+}
+
+/* 删除表项，其后同一冲突链上的表项前移填补，查找不会因空位提前结束 */
+static void load_task_drop(int i)
+{
+    int j = i;
+
+    memset(&load_task[i], 0, sizeof load_task[i]);
+
+    while (1)
+    {
+        sl_add(j, SL_LOAD_TASK_NUM - 1);
+
+        if (load_task[j].task == NULL)
+            break;
+
+        int k = load_home(load_task[j].task);
+
+        /* 起始位置在 (i, j] 内的表项无需前移 */
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        load_task[i] = load_task[j];
+
+        memset(&load_task[j], 0, sizeof load_task[j]);
+
+        i = j;
+    }
+}
+
+/* 回收报告期内没有运行过的表项（已停止的任务），其余表项重新开始计数 */
+static void load_task_recycle(void)
+{
+    for (int i = 0; i < SL_LOAD_TASK_NUM; i++)
+    {
+        while (load_task[i].task != NULL && load_task[i].used == 0)
+            load_task_drop(i);
+
+        load_task[i].used = 0;
+    }
+}
+
+#endif
+
+/* 清空任务统计表，如 sl_bench_run 结束时清除测量用的任务 */
+void sl_load_task_clear(void)
+{
+#if SL_LOAD_TASK_NUM
+    memset(load_task, 0, sizeof load_task);
+#endif
+}
+
+/* ============================================================== */
+
+/* 统计窗口结束，计算负载 */
+static void load_window(void)
+{
+    static char warning;
+
+    uint32_t now = sl_get_cycle();
+
+    uint32_t win = now - win_start;
+
+    /* 0.1% 对应的周期数 */
+    uint32_t unit = win / 1000;
+
+    win_start = now;
+
+    if (loop_num == 0 || unit == 0)
+        return;
+
+    loop_base = load_rebase(loop_base, loop_min);
+
+    uint32_t idle = loop_num * loop_base + loop_skip;
+
+    loop_skip = 0;
+
+    if (idle > win)
+        idle = win;
+
+    load.now = (win - idle) / unit;
+
+#if SL_LATENCY_ENABLE
+    sl_latency.cycle_us = (SysTick->LOAD + 1) / 1000;
+
+    sl_latency.loop.p99 = latency_pct(&sl_latency.loop, 10);
+
+    sl_latency.timer.p99 = latency_pct(&sl_latency.timer, 10);
+#endif
+
+    if (load.now > 1000)
+        load.now = 1000;
+
+    if (load.now > load.peak)
+        load.peak = load.now;
+
+    report_sum += load.now;
+
+    report_num++;
+
+    load.avg = report_sum / report_num;
+
+    loop_num = 0;
+
+    loop_min = UINT32_MAX;
+
+#if SL_LOAD_TASK_NUM
+    load_task_window(unit);
+#endif
+
+    /* 负载超过 80% 开始警告，低于 60% 解除 */
+    if (load.now > 800)
+        warning = 1;
+    else if (load.now < 600)
+        warning = 0;
+
+    /* 每秒最多警告一次 */
+    if (warning)
+        sl_error_ratelimit(1000, "cpu load over 80%%, reach %2d.%d%%", load.now / 10, load.now % 10);
+
+#if SL_SHED_ENABLE
+    sl_shed_update(load.now);
+#endif
+
+#if SL_GOV_ENABLE
+    sl_gov_update(load.now);
+#endif
+}
+
+#if SL_GOV_ENABLE
+
+/* 调频后调用：按新时钟重新开始统计窗口，空转基线重新学习（flash 等待周期随时钟变化）。
+ * 延迟直方图以周期为单位，一并清空 */
+void sl_load_clock(void)
+{
+    win_start = sl_get_cycle();
+
+    loop_last = win_start;
+
+    loop_num = 0;
+
+    loop_min = UINT32_MAX;
+
+    loop_base = 0;
+
+    loop_skip = 0;
+
+#if SL_LOAD_TASK_NUM
+    for (int i = 0; i < SL_LOAD_TASK_NUM; i++)
+    {
+        load_task_typ *t = &load_task[i];
+
+        t->cycles = 0;
+
+        t->calls = 0;
+
+        t->min = UINT32_MAX;
+
+        t->base = 0;
+    }
+#endif
+
+#if SL_LATENCY_ENABLE
+    sl_latency.cycle_us = (SysTick->LOAD + 1) / 1000;
+
+    latency_started = 0;
+
+    sl_latency_reset();
+#endif
+}
+
+#endif
+
+/* 获取 CPU 负载 */
+void sl_get_load(sl_load_typ *p)
+{
+    *p = load;
+}
+
+/* 打印 CPU 负载与各任务占比，并开始新的峰值/平均统计 */
+void sl_load_report(void)
+{
+    sl_printf("cpu load %2d.%d%%, peak %2d.%d%%, avg %2d.%d%%",
+              load.now / 10, load.now % 10, load.peak / 10, load.peak % 10, load.avg / 10, load.avg % 10);
+
+#if SL_LOAD_TASK_NUM
+    for (int i = 0; i < SL_LOAD_TASK_NUM && report_num > 0; i++)
+    {
+        load_task_typ *t = &load_task[i];
+
+        int avg = t->sum / report_num;
+
+        /* 函数地址可在 map 文件中查到任务名 */
+        if (avg > 0)
+            sl_printf("  task 0x%p %2d.%d%%", (void *)t->task, avg / 10, avg % 10);
+
+        t->sum = 0;
+    }
+
+    load_task_recycle();
+#endif
+
+    load.peak = load.now;
+
+    report_sum = 0;
+
+    report_num = 0;
+}
+
+/* 负载统计初始化 */
+void sl_load_init(void)
+{
+    win_start = sl_get_cycle();
+
+    /* 清除初始化之前（如 sl_bench_run）的轮次与任务统计 */
+    loop_last = win_start;
+
+    loop_num = 0;
+
+    loop_min = UINT32_MAX;
+
+    sl_load_task_clear();
+
+#if SL_LATENCY_ENABLE
+    latency_started = 0;
+
+    sl_latency_reset();
+#endif
+
+    sl_cycle_start(LOAD_WINDOW, load_window);
+
+#if SL_LOAD_REPORT_MS
+    sl_cycle_start(SL_LOAD_REPORT_MS, sl_load_report);
+
+    /* 过载时先降级诊断输出 */
+    sl_shed_set(sl_load_report, SL_SHED_STRETCH);
+#endif
+}
+
+/************************** END OF FILE **************************/
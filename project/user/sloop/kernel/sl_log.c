@@ -0,0 +1,1018 @@
+/**
+ ******************************************************************************
+ * @file    sl_log
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   日志服务：模块运行期等级、限频与去重、零拷贝 RTT 格式化、二进制日志与异步日志
+ *          二进制日志目标端不做格式化，只发送格式描述符地址、时间戳与原始参数
+ *          主机端使用 tools/sl_log.py 结合 axf 文件还原文本
+ *          异步日志打印时只写入 RAM 暂存队列，由并行任务在主循环中输出
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+#include "stdarg.h"
+
+/* 各模块运行期日志等级 */
+uint8_t sl_log_level[SL_MOD_NUM] = {[0 ... SL_MOD_NUM - 1] = SL_LOG_LEVEL_RUNTIME};
+
+/* 设置模块运行期日志等级，module 为 -1 时设置全部模块 */
+void sl_log_set_level(int module, int level)
+{
+    for (int i = 0; i < SL_MOD_NUM; i++)
+    {
+        if (module < 0 || module == i)
+            sl_log_level[i] = level;
+    }
+}
+
+/* ============================================================== */
+
+#if SL_RTT_ENABLE
+
+/* 查找下一个转换说明符，返回说明符字符位置，没有则返回 NULL */
+static const char *log_next_conv(const char *f)
+{
+    for (; *f; f++)
+    {
+        if (*f != '%')
+            continue;
+
+        f++;
+
+        /* 跳过标志、宽度、精度与长度修饰 */
+        while (*f == '-' || *f == '+' || *f == ' ' || *f == '#' || *f == '.' || *f == 'l' || *f == 'h' || (*f >= '0' && *f <= '9'))
+            f++;
+
+        if (*f == 0)
+            return NULL;
+
+        if (*f != '%')
+            return f;
+    }
+
+    return NULL;
+}
+
+#endif
+
+/* ============================================================== */
+
+#if SL_RTT_ENABLE
+
+/*
+ * 零拷贝格式化：一次预留上行缓冲区的剩余空间，逐字符直接写入环形缓冲区（自动回绕），
+ * 整条写完后只更新一次写偏移。提交前主机看不到任何字符，不会读到半条日志；
+ * 空间不足时整条丢弃，NO_BLOCK_TRIM 模式下保留已写入部分。
+ * 转换说明符与 SEGGER_RTT_printf 一致：%c %d %u %x %X %s %p %%，标志 - 0 +，宽度与精度
+ */
+
+/* 零拷贝格式化的使用者：同步打印（SL_LOG_ZERO_COPY）与异步文本日志 */
+#define RTT_ZERO_COPY (SL_LOG_ZERO_COPY || (SL_LOG_ASYNC && !SL_LOG_BINARY))
+
+#if RTT_ZERO_COPY
+
+/* 格式标志 */
+#define RTT_LEFT 0x01
+#define RTT_ZERO 0x02
+#define RTT_SIGN 0x04
+
+/* 上行缓冲区写游标 */
+typedef struct
+{
+    SEGGER_RTT_BUFFER_UP *ring;
+
+    /* 当前写位置 */
+    unsigned wr;
+
+    /* 预留的空间与所需长度（含放不下的部分） */
+    unsigned room;
+    unsigned len;
+
+    /* 空间不足时保留已写入部分 */
+    char trim;
+
+    /* 剩余可取用的参数个数，-1 为不限，取完后的转换说明符输出为 ? */
+    int args;
+
+} rtt_cur_typ;
+
+/* 预留上行缓冲区的剩余空间，须在 RTT 锁内调用 */
+static void rtt_reserve(rtt_cur_typ *c, unsigned idx)
+{
+    /* 首次打印时控制块尚未初始化 */
+    if (_SEGGER_RTT.acID[0] == 0)
+        SEGGER_RTT_Init();
+
+    c->ring = &_SEGGER_RTT.aUp[idx];
+
+    unsigned rd = c->ring->RdOff;
+
+    c->wr = c->ring->WrOff;
+
+    c->room = (rd > c->wr) ? rd - c->wr - 1 : c->ring->SizeOfBuffer - (c->wr - rd) - 1;
+
+    c->len = 0;
+
+    c->trim = (c->ring->Flags & SEGGER_RTT_MODE_MASK) == SEGGER_RTT_MODE_NO_BLOCK_TRIM;
+
+    c->args = -1;
+}
+
+/* 写入一个字符，超出预留空间只计长度 */
+static void rtt_putc(rtt_cur_typ *c, char ch)
+{
+    if (c->len++ >= c->room)
+        return;
+
+    c->ring->pBuffer[c->wr] = ch;
+
+    sl_add(c->wr, c->ring->SizeOfBuffer - 1);
+}
+
+static void rtt_puts(rtt_cur_typ *c, const char *s)
+{
+    while (*s)
+        rtt_putc(c, *s++);
+}
+
+/* 提交写偏移，返回写入字节数，空间不足整条丢弃时返回 -1 */
+static int rtt_commit(rtt_cur_typ *c)
+{
+    if (c->len > c->room && c->trim == 0)
+        return -1;
+
+    /* 数据写完后再提交写偏移 */
+    __DMB();
+
+    c->ring->WrOff = c->wr;
+
+    return (c->len > c->room) ? c->room : c->len;
+}
+
+/* 输出整数，宽度、精度与补零规则与 SEGGER_RTT_printf 一致，sign 为 0 表示无符号位 */
+static void rtt_number(rtt_cur_typ *c, uint32_t v, char sign, unsigned base, unsigned prec, unsigned width, int flags)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    char digit[10];
+
+    unsigned n = 0;
+
+    /* 逆序取各位，16 进制用移位，避免 M0+ 上的软件除法 */
+    do
+    {
+        digit[n++] = hex[(base == 16) ? (v & 15) : (v % 10)];
+
+        v = (base == 16) ? (v >> 4) : (v / 10);
+
+    } while (v);
+
+    unsigned num = (prec > n) ? prec : n;
+
+    unsigned total = num + (sign != 0);
+
+    char zero = (flags & RTT_ZERO) && !(flags & RTT_LEFT) && prec == 0;
+
+    for (; !(flags & RTT_LEFT) && !zero && total < width; total++)
+        rtt_putc(c, ' ');
+
+    if (sign)
+        rtt_putc(c, sign);
+
+    for (; zero && total < width; total++)
+        rtt_putc(c, '0');
+
+    for (; num > n; num--)
+        rtt_putc(c, '0');
+
+    while (n > 0)
+        rtt_putc(c, digit[--n]);
+
+    for (; (flags & RTT_LEFT) && total < width; total++)
+        rtt_putc(c, ' ');
+}
+
+/* 按格式串直接写入缓冲区 */
+static void rtt_format(rtt_cur_typ *c, const char *f, va_list *ap)
+{
+    for (; *f; f++)
+    {
+        if (*f != '%')
+        {
+            rtt_putc(c, *f);
+
+            continue;
+        }
+
+        int flags = 0;
+
+        unsigned width = 0;
+
+        unsigned prec = 0;
+
+        for (f++;; f++)
+        {
+            if (*f == '-')
+                flags |= RTT_LEFT;
+            else if (*f == '0')
+                flags |= RTT_ZERO;
+            else if (*f == '+')
+                flags |= RTT_SIGN;
+            else if (*f != '#')
+                break;
+        }
+
+        while (*f >= '0' && *f <= '9')
+            width = width * 10 + (*f++ - '0');
+
+        if (*f == '.')
+        {
+            for (f++; *f >= '0' && *f <= '9'; f++)
+                prec = prec * 10 + (*f - '0');
+        }
+
+        while (*f == 'l' || *f == 'h')
+            f++;
+
+        /* 参数已取完，不再读取可变参数 */
+        if (*f != 0 && *f != '%' && c->args == 0)
+        {
+            rtt_putc(c, '?');
+
+            continue;
+        }
+
+        if (*f != 0 && *f != '%' && c->args > 0)
+            c->args--;
+
+        switch (*f)
+        {
+        case 0:
+            return;
+
+        case 'c':
+            rtt_putc(c, (char)va_arg(*ap, int));
+            break;
+
+        case 'd':
+        {
+            int v = va_arg(*ap, int);
+
+            char sign = (v < 0) ? '-' : ((flags & RTT_SIGN) ? '+' : 0);
+
+            rtt_number(c, (v < 0) ? 0u - (uint32_t)v : (uint32_t)v, sign, 10, prec, width, flags);
+            break;
+        }
+
+        case 'u':
+            rtt_number(c, va_arg(*ap, unsigned), 0, 10, prec, width, flags);
+            break;
+
+        case 'x':
+        case 'X':
+            rtt_number(c, va_arg(*ap, unsigned), 0, 16, prec, width, flags);
+            break;
+
+        case 's':
+        {
+            const char *s = va_arg(*ap, const char *);
+
+            rtt_puts(c, (s != NULL) ? s : "(NULL)");
+            break;
+        }
+
+        case 'p':
+            rtt_number(c, (uint32_t)(uintptr_t)va_arg(*ap, void *), 0, 16, 8, 8, 0);
+            break;
+
+        case '%':
+            rtt_putc(c, '%');
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+#if (SL_LOG_ASYNC && !SL_LOG_BINARY) || (SL_LOG_ZERO_COPY && !SL_LOG_DEFER)
+
+/* 按格式串写入游标，供同一条日志分段拼接（异步文本日志、去重打印） */
+static void rtt_cprintf(rtt_cur_typ *c, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+
+    rtt_format(c, fmt, &ap);
+
+    va_end(ap);
+}
+
+#endif
+
+#endif
+
+/* 格式化打印到 RTT 上行缓冲区，格式与 SEGGER_RTT_printf 一致，零拷贝时整条一次提交 */
+int sl_rtt_printf(unsigned idx, const char *sFormat, ...)
+{
+    int r;
+
+    va_list ap;
+
+    va_start(ap, sFormat);
+
+#if SL_LOG_ZERO_COPY
+    if ((_SEGGER_RTT.aUp[idx].Flags & SEGGER_RTT_MODE_MASK) == SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL)
+    {
+        /* 阻塞模式需要边写边等主机读取，仍走分段拷贝 */
+        r = SEGGER_RTT_vprintf(idx, sFormat, &ap);
+    }
+    else
+    {
+        rtt_cur_typ c;
+
+        /* 整条格式化期间关中断，时长见 sl_config.h */
+        SEGGER_RTT_LOCK();
+
+        rtt_reserve(&c, idx);
+
+        rtt_format(&c, sFormat, &ap);
+
+        r = rtt_commit(&c);
+
+        SEGGER_RTT_UNLOCK();
+    }
+#else
+    /* 分段拷贝：在栈上格式化，每 SEGGER_RTT_PRINTF_BUFFER_SIZE 字节关一次中断写入 */
+    r = SEGGER_RTT_vprintf(idx, sFormat, &ap);
+#endif
+
+    va_end(ap);
+
+    return r;
+}
+
+/* ============================================================== */
+
+#if SL_TRACE_ENABLE
+static char rtt_trace_buf[SL_TRACE_RTT_SIZE];
+#endif
+
+#if SL_RTT_TELE_SIZE
+static char rtt_tele_buf[SL_RTT_TELE_SIZE];
+#endif
+
+/* RTT 通道布局：通道0 文本日志（缓冲区在 SEGGER_RTT.c 中），通道1 Flow 跟踪，通道2 变量遥测。
+ * 高速二进制流各用独立缓冲区与溢出模式，不会挤掉错误日志 */
+void sl_rtt_init(void)
+{
+#if SL_TRACE_ENABLE
+    SEGGER_RTT_ConfigUpBuffer(SL_RTT_CH_TRACE, "sl_trace", rtt_trace_buf, sizeof rtt_trace_buf, SL_TRACE_RTT_MODE);
+#endif
+
+#if SL_RTT_TELE_SIZE
+    SEGGER_RTT_ConfigUpBuffer(SL_RTT_CH_TELE, "sl_tele", rtt_tele_buf, sizeof rtt_tele_buf, SL_RTT_TELE_MODE);
+#endif
+}
+
+#endif
+
+/* ============================================================== */
+
+/* 已使用过的限频/去重调用点链表，周期汇总时遍历 */
+static sl_log_limit_typ *limit_list;
+
+/* 输出被抑制条数的汇总 */
+static void limit_flush(sl_log_limit_typ *e)
+{
+    if (e->count == 0)
+        return;
+
+    sl_printf("last message repeated %d times: %s", e->count, e->fmt);
+
+    e->count = 0;
+}
+
+/* 限频/去重检查，返回 1 表示应输出。e 为调用点自己的状态，O(1)，被抑制时只计数 */
+char sl_log_limit(sl_log_limit_typ *e, const char *fmt, int period, uint32_t hash)
+{
+    uint32_t now = sl_get_tick();
+
+    /* 相同内容且仍在周期内，抑制 */
+    if (e->linked && e->hash == hash && (uint32_t)(now - e->tick) < period)
+    {
+        e->count++;
+
+        return 0;
+    }
+
+    /* 首次使用，登记到链表：先写 next 再更新表头，周期汇总任务遍历时不会读到半个节点 */
+    if (e->linked == 0)
+    {
+        e->next = limit_list;
+
+        limit_list = e;
+
+        e->linked = 1;
+    }
+
+    /* 换了内容，先汇总之前的重复 */
+    limit_flush(e);
+
+    e->fmt = fmt;
+
+    e->hash = hash;
+
+    e->tick = now;
+
+    e->period = period;
+
+    return 1;
+}
+
+#if SL_RTT_ENABLE
+
+/* 计算参数哈希，用于去重：%s 按内容，其余按原始值 */
+static uint32_t log_hash(const char *fmt, va_list ap)
+{
+    uint32_t hash = 2166136261u;
+
+    for (const char *f = fmt; (f = log_next_conv(f)) != NULL; f++)
+    {
+        if (*f == 's')
+        {
+            for (const char *s = va_arg(ap, const char *); *s; s++)
+                hash = (hash ^ (uint8_t)*s) * 16777619u;
+        }
+        else
+        {
+            uint32_t v = (*f == 'p') ? (uint32_t)(uintptr_t)va_arg(ap, void *) : (uint32_t)va_arg(ap, int);
+
+            hash = (hash ^ v) * 16777619u;
+        }
+    }
+
+    /* 0 保留给限频 */
+    return hash ? hash : 1;
+}
+
+#endif
+
+/* 周期汇总：重复已停止的表项也输出重复次数 */
+static void limit_sweep(void)
+{
+    uint32_t now = sl_get_tick();
+
+    for (sl_log_limit_typ *e = limit_list; e != NULL; e = e->next)
+    {
+        if (e->count && (uint32_t)(now - e->tick) >= e->period)
+        {
+            limit_flush(e);
+        }
+    }
+}
+
+/* 限频/去重初始化 */
+void sl_log_limit_init(void)
+{
+    sl_cycle_start(1000, limit_sweep);
+}
+
+/* ============================================================== */
+
+#if SL_LOG_DEFER
+
+/*
+ * 帧格式（小端，无对齐）：
+ * [0]     负载长度 len
+ * [1..4]  格式描述符地址
+ * [5..8]  时间戳 ms
+ * [9..]   负载：按格式串顺序，%s 为以 0 结尾的字符串，其余转换各 4 字节
+ *
+ * 整帧一次写入 RTT，通道满时整帧丢弃，不会出现半帧
+ */
+
+/* 帧头长度 */
+#define LOG_HEAD_SIZE 9
+
+/* 丢弃的日志条数 */
+volatile uint32_t sl_log_drop;
+
+/* ============================================================== */
+
+/* 按字节写入 4 字节小端值 */
+static uint8_t *log_put_word(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+
+    p[1] = v >> 8;
+
+    p[2] = v >> 16;
+
+    p[3] = v >> 24;
+
+    return p + 4;
+}
+
+#if SL_LOG_ASYNC
+
+/* 按字节读取 4 字节小端值 */
+static uint32_t log_get_word(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+#endif
+
+/* 编码一帧，只扫描转换说明符以确定参数个数与类型，不做任何数字转换，返回帧长度 */
+static int log_encode(uint8_t *frame, const sl_log_desc_typ *desc, va_list ap)
+{
+    uint8_t *p = frame + LOG_HEAD_SIZE;
+
+    uint8_t *end = frame + SL_LOG_FRAME_SIZE;
+
+    for (const char *f = desc->fmt; (f = log_next_conv(f)) != NULL; f++)
+    {
+        if (*f == 's')
+        {
+            const char *s = va_arg(ap, const char *);
+
+            if (p >= end)
+                break;
+
+            /* 字符串按值复制，超长截断，始终保留结尾 0 */
+            while (*s && p < end - 1)
+                *p++ = *s++;
+
+            *p++ = 0;
+        }
+        else
+        {
+            uint32_t v = (*f == 'p') ? (uint32_t)(uintptr_t)va_arg(ap, void *) : (uint32_t)va_arg(ap, int);
+
+            /* 放不下的参数截断，主机端显示为 ? */
+            if (end - p < 4)
+                break;
+
+            p = log_put_word(p, v);
+        }
+    }
+
+    frame[0] = p - frame - LOG_HEAD_SIZE;
+
+    log_put_word(frame + 1, (uint32_t)(uintptr_t)desc);
+
+    log_put_word(frame + 5, sl_get_tick());
+
+    return p - frame;
+}
+
+/* ============================================================== */
+
+#if !SL_LOG_ASYNC
+
+/* 写入一条二进制日志，整帧写入 RTT */
+static void log_vwrite(const sl_log_desc_typ *desc, va_list ap)
+{
+    uint8_t frame[SL_LOG_FRAME_SIZE];
+
+    int len = log_encode(frame, desc, ap);
+
+    if (SEGGER_RTT_Write(SL_RTT_CH_TEXT, frame, len) == 0)
+        sl_log_drop++;
+}
+
+#else
+
+/*
+ * 暂存队列按执行上下文划分：线程模式一个，每个中断优先级一个，HardFault 与 NMI 各一个。
+ * 同一优先级的中断不会相互抢占，每个队列只有一个写者（该上下文）和一个读者（主循环），
+ * 读写序号各自只由一方修改，无需关中断，任何优先级的中断都可以直接打印。
+ *
+ * 队列记录：[格式描述符指针][帧]
+ */
+
+/* 上下文数：线程模式 + 各中断优先级 + HardFault + NMI */
+#define LOG_CTX_NUM (3 + (1 << __NVIC_PRIO_BITS))
+
+/* 记录中描述符指针长度 */
+#define LOG_PTR_SIZE sizeof(const sl_log_desc_typ *)
+
+typedef struct
+{
+    /* 读写序号（自由递增），写序号只由所属上下文修改，读序号只由主循环修改 */
+    volatile uint32_t wr;
+    volatile uint32_t rd;
+
+    /* 队列满丢弃的条数，只由所属上下文修改 */
+    volatile uint32_t drop;
+
+} log_ring_typ;
+
+static uint8_t log_thread_buf[SL_LOG_QUEUE_SIZE];
+
+static uint8_t log_isr_buf[LOG_CTX_NUM - 1][SL_LOG_ISR_QUEUE_SIZE];
+
+static log_ring_typ log_ring[LOG_CTX_NUM];
+
+/* 各上下文队列的缓冲区与大小（须为2的幂） */
+#define LOG_RING_BUF(ctx) ((ctx) == 0 ? log_thread_buf : log_isr_buf[(ctx) - 1])
+#define LOG_RING_SIZE(ctx) ((ctx) == 0 ? SL_LOG_QUEUE_SIZE : SL_LOG_ISR_QUEUE_SIZE)
+
+/* 当前上下文：0 为线程模式，其后为 1 + 中断优先级，最后两个为 HardFault 与 NMI */
+static int log_ctx(void)
+{
+    uint32_t ipsr = __get_IPSR();
+
+    if (ipsr == 0)
+        return 0;
+
+    /* NMI 可抢占 HardFault，两者都可抢占优先级 0 的中断，不能与之共用队列 */
+    if (ipsr == 2)
+        return LOG_CTX_NUM - 1;
+
+    if (ipsr == 3)
+        return LOG_CTX_NUM - 2;
+
+    return 1 + NVIC_GetPriority((IRQn_Type)((int)ipsr - 16));
+}
+
+/* 按字节写入队列，自动回绕 */
+static void ring_put(int ctx, uint32_t pos, const uint8_t *src, int len)
+{
+    uint8_t *buf = LOG_RING_BUF(ctx);
+
+    for (int i = 0; i < len; i++)
+        buf[(pos + i) & (LOG_RING_SIZE(ctx) - 1)] = src[i];
+}
+
+/* 按字节读出队列，自动回绕 */
+static void ring_get(int ctx, uint32_t pos, uint8_t *dst, int len)
+{
+    uint8_t *buf = LOG_RING_BUF(ctx);
+
+    for (int i = 0; i < len; i++)
+        dst[i] = buf[(pos + i) & (LOG_RING_SIZE(ctx) - 1)];
+}
+
+/* 写入一条日志到当前上下文的暂存队列，可在任意优先级中断中调用，不关中断 */
+static void log_vwrite(const sl_log_desc_typ *desc, va_list ap)
+{
+    uint8_t rec[LOG_PTR_SIZE + SL_LOG_FRAME_SIZE];
+
+    int ctx = log_ctx();
+
+    log_ring_typ *r = &log_ring[ctx];
+
+    int len = LOG_PTR_SIZE + log_encode(rec + LOG_PTR_SIZE, desc, ap);
+
+    memcpy(rec, &desc, LOG_PTR_SIZE);
+
+    if (LOG_RING_SIZE(ctx) - (r->wr - r->rd) < len)
+    {
+        r->drop++;
+
+        return;
+    }
+
+    ring_put(ctx, r->wr, rec, len);
+
+    /* 数据写完后再提交写序号 */
+    __DMB();
+
+    r->wr += len;
+}
+
+#if SL_LOG_BINARY
+
+/* 输出一帧，通道空间不足返回 0 */
+static char log_output(const sl_log_desc_typ *desc, const uint8_t *frame)
+{
+    return SEGGER_RTT_Write(SL_RTT_CH_TEXT, frame, LOG_HEAD_SIZE + frame[0]) != 0;
+}
+
+#else
+
+/* 文本渲染的参数上限，超出的转换说明符输出为 ? */
+#define LOG_ARG_MAX 8
+
+/* 各日志类型的前后缀，与同步文本模式的打印宏一致 */
+static const char *const log_prefix[] = {
+    [SL_LOG_TEXT] = "",
+    [SL_LOG_FUNC] = "",
+    [SL_LOG_ERROR] = RTT_CTRL_TEXT_BRIGHT_RED "[error] ",
+    [SL_LOG_FOCUS] = RTT_CTRL_TEXT_BRIGHT_WHITE "=== ",
+    [SL_LOG_WHITE] = RTT_CTRL_TEXT_BRIGHT_WHITE,
+    [SL_LOG_YELLOW] = RTT_CTRL_TEXT_BRIGHT_YELLOW,
+    [SL_LOG_RAW] = RTT_CTRL_TEXT_YELLOW,
+    [SL_LOG_WARN] = RTT_CTRL_TEXT_BRIGHT_YELLOW "[warn] ",
+};
+
+static const char *const log_suffix[] = {
+    [SL_LOG_TEXT] = "",
+    [SL_LOG_FUNC] = "",
+    [SL_LOG_ERROR] = RTT_CTRL_RESET,
+    [SL_LOG_FOCUS] = " ===" RTT_CTRL_RESET,
+    [SL_LOG_WHITE] = RTT_CTRL_RESET,
+    [SL_LOG_YELLOW] = RTT_CTRL_RESET,
+    [SL_LOG_RAW] = RTT_CTRL_RESET,
+    [SL_LOG_WARN] = RTT_CTRL_RESET,
+};
+
+/* 将一帧格式化为文本，整条一次写入 RTT，通道空间不足返回 0 */
+static char log_output(const sl_log_desc_typ *desc, const uint8_t *frame)
+{
+    /* 上次放不下时所需的空间，空间未恢复前不再重复格式化 */
+    static unsigned need;
+
+    const uint8_t *p = frame + LOG_HEAD_SIZE;
+
+    const uint8_t *end = p + frame[0];
+
+    uintptr_t arg[LOG_ARG_MAX];
+
+    /* 还原参数：%s 指向帧内字符串，其余为原始值，被截断的参数显示为 ? 或 0 */
+    const char *f = desc->fmt;
+
+    for (int i = 0; i < LOG_ARG_MAX; i++)
+    {
+        if (f != NULL)
+            f = log_next_conv(f);
+
+        if (f != NULL && *f == 's')
+        {
+            arg[i] = (uintptr_t)(p < end ? (const char *)p : "?");
+
+            p += (p < end) ? strlen((const char *)p) + 1 : 0;
+        }
+        else if (f != NULL && end - p >= 4)
+        {
+            arg[i] = log_get_word(p);
+
+            p += 4;
+        }
+        else
+        {
+            arg[i] = 0;
+        }
+
+        if (f != NULL)
+            f++;
+    }
+
+    uint32_t t = log_get_word(frame + 5);
+
+    rtt_cur_typ c;
+
+    int r = -1;
+
+    SEGGER_RTT_LOCK();
+
+    rtt_reserve(&c, SL_RTT_CH_TEXT);
+
+    if (c.room >= need)
+    {
+        if (desc->type != SL_LOG_RAW)
+        {
+            rtt_cprintf(&c, RTT_CTRL_TEXT_GREEN "\n[%02d %02d:%02d:%02d.%03d] " RTT_CTRL_TEXT_YELLOW,
+                        t / 1000 / 60 / 60 / 24, t / 1000 / 60 / 60 % 24, t / 1000 / 60 % 60, t / 1000 % 60, t % 1000);
+        }
+
+        rtt_puts(&c, log_prefix[desc->type]);
+
+        /* 参数按机器字传入，格式串至多取用 LOG_ARG_MAX 个 */
+        c.args = LOG_ARG_MAX;
+
+        rtt_cprintf(&c, desc->fmt, arg[0], arg[1], arg[2], arg[3], arg[4], arg[5], arg[6], arg[7]);
+
+        c.args = -1;
+
+        rtt_puts(&c, log_suffix[desc->type]);
+
+        if (desc->func != NULL)
+            rtt_cprintf(&c, RTT_CTRL_TEXT_GREEN " <func: %s>" RTT_CTRL_RESET, desc->func);
+
+        if (desc->type != SL_LOG_RAW)
+            rtt_puts(&c, "\n" RTT_CTRL_RESET);
+
+        r = rtt_commit(&c);
+    }
+
+    SEGGER_RTT_UNLOCK();
+
+    if (r >= 0)
+    {
+        need = 0;
+
+        return 1;
+    }
+
+    /* 超过整个缓冲区的记录永远放不下，直接丢弃 */
+    if (c.len >= c.ring->SizeOfBuffer)
+    {
+        need = 0;
+
+        return 1;
+    }
+
+    if (c.len > need)
+        need = c.len;
+
+    return 0;
+}
+
+#endif
+
+/* 查找时间戳最早的记录所在上下文，均为空返回 -1 */
+static int log_oldest(void)
+{
+    int oldest = -1;
+
+    uint32_t oldest_tick = 0;
+
+    for (int i = 0; i < LOG_CTX_NUM; i++)
+    {
+        log_ring_typ *r = &log_ring[i];
+
+        if (r->rd == r->wr)
+            continue;
+
+        uint8_t tick[4];
+
+        ring_get(i, r->rd + LOG_PTR_SIZE + 5, tick, 4);
+
+        uint32_t t = log_get_word(tick);
+
+        if (oldest < 0 || (int32_t)(t - oldest_tick) < 0)
+        {
+            oldest = i;
+
+            oldest_tick = t;
+        }
+    }
+
+    return oldest;
+}
+
+/* 输出暂存队列，按时间戳合并各上下文的记录，每轮主循环最多 SL_LOG_DRAIN_NUM 条 */
+static void log_drain(void)
+{
+    static uint32_t drop_report;
+
+    uint8_t rec[LOG_PTR_SIZE + SL_LOG_FRAME_SIZE];
+
+    const sl_log_desc_typ *desc;
+
+    for (int i = 0; i < SL_LOG_DRAIN_NUM; i++)
+    {
+        int ctx = log_oldest();
+
+        if (ctx < 0)
+            break;
+
+        log_ring_typ *r = &log_ring[ctx];
+
+        ring_get(ctx, r->rd, rec, LOG_PTR_SIZE + LOG_HEAD_SIZE);
+
+        int len = LOG_PTR_SIZE + LOG_HEAD_SIZE + rec[LOG_PTR_SIZE];
+
+        ring_get(ctx, r->rd, rec, len);
+
+        memcpy(&desc, rec, LOG_PTR_SIZE);
+
+        /* 通道已满，记录留在队列中下轮再发 */
+        if (log_output(desc, rec + LOG_PTR_SIZE) == 0)
+            break;
+
+        r->rd += len;
+    }
+
+    /* 汇总各队列丢弃条数 */
+    uint32_t drop = 0;
+
+    for (int i = 0; i < LOG_CTX_NUM; i++)
+        drop += log_ring[i].drop;
+
+    sl_log_drop = drop;
+
+    /* 报告丢弃条数，报告本身写入线程队列 */
+    if (drop != drop_report && SL_LOG_QUEUE_SIZE - (log_ring[0].wr - log_ring[0].rd) >= LOG_PTR_SIZE + SL_LOG_FRAME_SIZE)
+    {
+        sl_warn("%d logs dropped", (int)(drop - drop_report));
+
+        drop_report = drop;
+    }
+}
+
+/* 异步日志初始化 */
+void sl_log_init(void)
+{
+    sl_task_start(log_drain);
+}
+
+#endif
+
+/* 写入一条二进制/异步日志 */
+void sl_log_write(const sl_log_desc_typ *desc, ...)
+{
+    va_list ap;
+
+    va_start(ap, desc);
+
+    log_vwrite(desc, ap);
+
+    va_end(ap);
+}
+
+/* 去重打印：先以参数副本计算哈希，需要输出时用同一组参数写入 */
+void sl_log_dedup(sl_log_limit_typ *limit, const sl_log_desc_typ *desc, ...)
+{
+    va_list ap, cp;
+
+    va_start(ap, desc);
+
+    va_copy(cp, ap);
+
+    uint32_t hash = log_hash(desc->fmt, cp);
+
+    va_end(cp);
+
+    if (sl_log_limit(limit, desc->fmt, SL_LOG_DEDUP_MS, hash))
+        log_vwrite(desc, ap);
+
+    va_end(ap);
+}
+
+#elif SL_RTT_ENABLE
+
+/* 去重打印：先以参数副本计算哈希，需要输出时用同一组参数打印，格式与 sl_printf/sl_error 一致 */
+void sl_log_dedup(sl_log_limit_typ *limit, int type, const char *func, const char *sFormat, ...)
+{
+    va_list ap, cp;
+
+    va_start(ap, sFormat);
+
+    va_copy(cp, ap);
+
+    uint32_t hash = log_hash(sFormat, cp);
+
+    va_end(cp);
+
+    if (sl_log_limit(limit, sFormat, SL_LOG_DEDUP_MS, hash) == 0)
+    {
+        va_end(ap);
+
+        return;
+    }
+
+    uint32_t t = sl_get_tick();
+
+    const char *head = (type == SL_LOG_ERROR) ? RTT_CTRL_TEXT_BRIGHT_RED "[error] " : "";
+
+    const char *tail = (type == SL_LOG_ERROR) ? RTT_CTRL_RESET : "";
+
+#if SL_LOG_ZERO_COPY
+    if ((_SEGGER_RTT.aUp[SL_RTT_CH_TEXT].Flags & SEGGER_RTT_MODE_MASK) != SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL)
+    {
+        rtt_cur_typ c;
+
+        SEGGER_RTT_LOCK();
+
+        rtt_reserve(&c, SL_RTT_CH_TEXT);
+
+        rtt_cprintf(&c, RTT_CTRL_TEXT_GREEN "\n[%02d %02d:%02d:%02d.%03d] " RTT_CTRL_TEXT_YELLOW "%s",
+                    t / 1000 / 60 / 60 / 24, t / 1000 / 60 / 60 % 24, t / 1000 / 60 % 60, t / 1000 % 60, t % 1000, head);
+
+        rtt_format(&c, sFormat, &ap);
+
+        rtt_cprintf(&c, "%s" RTT_CTRL_TEXT_GREEN " <func: %s>" RTT_CTRL_RESET "\n" RTT_CTRL_RESET, tail, func);
+
+        rtt_commit(&c);
+
+        SEGGER_RTT_UNLOCK();
+
+        va_end(ap);
+
+        return;
+    }
+#endif
+
+    /* 分段拷贝，与 SL_LOG_ZERO_COPY 为 0 时的 sl_rtt_printf 一致 */
+    SEGGER_RTT_printf(SL_RTT_CH_TEXT, RTT_CTRL_TEXT_GREEN "\n[%02d %02d:%02d:%02d.%03d] " RTT_CTRL_TEXT_YELLOW "%s",
+                      t / 1000 / 60 / 60 / 24, t / 1000 / 60 / 60 % 24, t / 1000 / 60 % 60, t / 1000 % 60, t % 1000, head);
+
+    SEGGER_RTT_vprintf(SL_RTT_CH_TEXT, sFormat, &ap);
+
+    SEGGER_RTT_printf(SL_RTT_CH_TEXT, "%s" RTT_CTRL_TEXT_GREEN " <func: %s>" RTT_CTRL_RESET "\n" RTT_CTRL_RESET, tail, func);
+
+    va_end(ap);
+}
+
+#endif
+
+/************************** END OF FILE **************************/
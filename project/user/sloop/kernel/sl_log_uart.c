@@ -0,0 +1,247 @@
+/**
+ ******************************************************************************
+ * @file    sl_log_uart
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   UART+DMA 日志后端：把 RTT 通道0中的日志经 UART 发出，用于未连接 J-Link 的设备
+ *          DMA 双缓冲：一块发送时主循环填充另一块，发送完成中断中立即切换，CPU 不等待串口
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+#if SL_RTT_ENABLE && SL_LOG_BACKEND == SL_BACKEND_UART
+
+/*
+ * 所有日志（文本、二进制、异步）照常写入 RTT 通道0，该通道即作为发送 FIFO，
+ * 由并行任务搬运到空闲的 DMA 缓冲。
+ *
+ * 硬件默认：USART1 TX = PA9 (AF1)，DMA1 通道1。
+ * 其他板卡可重新实现 sl_log_uart_hw_init / sl_log_uart_hw_send / sl_log_uart_hw_idle / sl_log_uart_hw_clock（弱定义），
+ * 发送完成时调用 sl_log_uart_tx_done。
+ */
+
+/* 双缓冲 */
+static uint8_t uart_buf[2][SL_LOG_UART_BUF_SIZE];
+
+/* 各缓冲中的字节数 */
+static int uart_len[2];
+
+/* 主循环正在填充的缓冲 */
+static volatile uint8_t uart_fill;
+
+/* DMA 发送中 */
+static volatile char uart_busy;
+
+/* 主循环正在填充，发送完成中断不得取走填充缓冲 */
+static volatile char uart_filling;
+
+/* ============================================================== */
+
+void sl_log_uart_hw_init(void);
+void sl_log_uart_hw_send(const uint8_t *buf, int len);
+char sl_log_uart_hw_idle(void);
+void sl_log_uart_hw_clock(void);
+
+/* 发送填充缓冲并切换，调用前须确认 DMA 空闲且缓冲非空 */
+static void uart_kick(void)
+{
+    uint8_t send = uart_fill;
+
+    uart_busy = 1;
+
+    uart_fill = send ^ 1;
+
+    uart_len[uart_fill] = 0;
+
+    sl_log_uart_hw_send(uart_buf[send], uart_len[send]);
+}
+
+/* 发送完成，在 DMA 中断中调用 */
+void sl_log_uart_tx_done(void)
+{
+    uart_busy = 0;
+
+    /* 另一块已有数据，立即续发，无需等待主循环 */
+    if (uart_filling == 0 && uart_len[uart_fill] > 0)
+        uart_kick();
+}
+
+/* 从 RTT 通道0搬运数据到填充缓冲，DMA 空闲时发出 */
+static void uart_pump(void)
+{
+    /* 先置填充标志再读填充缓冲：发送完成中断在两者之间切换缓冲时会看到标志而不再发出 */
+    uart_filling = 1;
+
+    __DMB();
+
+    uint8_t fill = uart_fill;
+
+    if (uart_len[fill] < SL_LOG_UART_BUF_SIZE)
+        uart_len[fill] += SEGGER_RTT_ReadUpBuffer(SL_RTT_CH_TEXT, uart_buf[fill] + uart_len[fill], SL_LOG_UART_BUF_SIZE - uart_len[fill]);
+
+    uart_filling = 0;
+
+    __disable_irq();
+
+    if (uart_busy == 0 && uart_len[uart_fill] > 0)
+        uart_kick();
+
+    __enable_irq();
+}
+
+/* 发送已全部完成，可以切换时钟 */
+char sl_log_uart_idle(void)
+{
+    return uart_busy == 0 && sl_log_uart_hw_idle();
+}
+
+/* 时钟切换后按新的 PCLK 重新设置波特率，须在发送空闲时调用 */
+void sl_log_uart_clock(void)
+{
+    sl_log_uart_hw_clock();
+}
+
+/* UART 日志后端初始化 */
+void sl_log_uart_init(void)
+{
+    sl_log_uart_hw_init();
+
+    sl_task_start(uart_pump);
+}
+
+/* ============================================================== */
+
+#if SL_LOG_UART_STUB
+
+/*
+ * 主机测试桩：不访问硬件，发送内容交给 sl_log_uart_sink，
+ * 按波特率估算发送耗时，到时再调用发送完成，模拟 DMA 的背压
+ */
+
+/* 发送内容输出，主机测试中重新实现 */
+sl_weak void sl_log_uart_sink(const uint8_t *buf, int len) {}
+
+static void stub_done(void)
+{
+    sl_log_uart_tx_done();
+}
+
+void sl_log_uart_hw_init(void) {}
+
+void sl_log_uart_hw_send(const uint8_t *buf, int len)
+{
+    sl_log_uart_sink(buf, len);
+
+    /* 每字节 10 位 */
+    int ms = len * 10 * 1000 / SL_LOG_UART_BAUD;
+
+    sl_timeout_start(ms > 0 ? ms : 1, stub_done);
+}
+
+char sl_log_uart_hw_idle(void)
+{
+    return 1;
+}
+
+void sl_log_uart_hw_clock(void) {}
+
+#else
+
+static DMA_HandleTypeDef uart_dma;
+
+static void uart_dma_done(DMA_HandleTypeDef *hdma)
+{
+    sl_log_uart_tx_done();
+}
+
+sl_weak void sl_log_uart_hw_init(void)
+{
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    __HAL_RCC_USART1_CLK_ENABLE();
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    GPIO_InitTypeDef io = {0};
+
+    io.Pin = GPIO_PIN_9;
+
+    io.Mode = GPIO_MODE_AF_PP;
+
+    io.Pull = GPIO_NOPULL;
+
+    io.Speed = GPIO_SPEED_FREQ_HIGH;
+
+    io.Alternate = GPIO_AF1_USART1;
+
+    HAL_GPIO_Init(GPIOA, &io);
+
+    /* 8N1，只开发送，发送经 DMA */
+    USART1->BRR = HAL_RCC_GetPCLK1Freq() / SL_LOG_UART_BAUD;
+
+    USART1->CR3 = USART_CR3_DMAT;
+
+    USART1->CR1 = USART_CR1_TE | USART_CR1_UE;
+
+    uart_dma.Instance = DMA1_Channel1;
+
+    uart_dma.Init.Request = DMA_REQUEST_USART1_TX;
+
+    uart_dma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+
+    uart_dma.Init.PeriphInc = DMA_PINC_DISABLE;
+
+    uart_dma.Init.MemInc = DMA_MINC_ENABLE;
+
+    uart_dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+
+    uart_dma.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+
+    uart_dma.Init.Mode = DMA_NORMAL;
+
+    uart_dma.Init.Priority = DMA_PRIORITY_LOW;
+
+    HAL_DMA_Init(&uart_dma);
+
+    uart_dma.XferCpltCallback = uart_dma_done;
+
+    /* 日志发送不紧急，使用最低中断优先级 */
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 3, 0);
+
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+}
+
+sl_weak void sl_log_uart_hw_send(const uint8_t *buf, int len)
+{
+    HAL_DMA_Start_IT(&uart_dma, (uint32_t)buf, (uint32_t)&USART1->TDR, len);
+}
+
+/* DMA 完成后移位寄存器中仍有最后一个字节，等待发送完成标志 */
+sl_weak char sl_log_uart_hw_idle(void)
+{
+    return (USART1->ISR & USART_ISR_TC) != 0;
+}
+
+sl_weak void sl_log_uart_hw_clock(void)
+{
+    USART1->CR1 &= ~USART_CR1_UE;
+
+    USART1->BRR = HAL_RCC_GetPCLK1Freq() / SL_LOG_UART_BAUD;
+
+    USART1->CR1 |= USART_CR1_UE;
+}
+
+void DMA1_Channel1_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&uart_dma);
+}
+
+#endif
+
+#endif
+
+/************************** END OF FILE **************************/
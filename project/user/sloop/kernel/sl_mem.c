@@ -0,0 +1,157 @@
+/**
+ ******************************************************************************
+ * @file    sl_mem
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   栈填充与栈/注册表峰值统计：启动时填充栈，周期检查栈峰值，接近溢出时警告
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+/*
+ * sl_wait 中会嵌套运行并行任务，并行任务中又可以调用 sl_wait，栈深度无法静态确定，
+ * 溢出后会静默改写注册表。启动时把栈的空闲部分填满固定值，此后从栈底向上找到第一个被改写的字，
+ * 即为历史最深处。注册表峰值在登记时更新，见 sl_mem_peak。
+ */
+
+sl_mem_typ sl_mem;
+
+#if SL_STACK_CHECK_ENABLE
+
+/* 栈填充值 */
+#define STACK_PAINT 0xC5C5C5C5
+
+/* 栈检查周期 ms */
+#define STACK_CHECK_MS 1000
+
+/* 栈区间 */
+static uint32_t *stack_bottom;
+static uint32_t *stack_top;
+
+/* ============================================================== */
+
+/* 获取栈区间 [bottom, top)，默认取启动文件中的 STACK 段，其他工具链或链接脚本可重新实现 */
+sl_weak void sl_stack_region(uint32_t **bottom, uint32_t **top)
+{
+#if defined(__ARMCC_VERSION)
+    extern uint32_t STACK$$Base[];
+    extern uint32_t STACK$$Limit[];
+
+    *bottom = STACK$$Base;
+
+    *top = STACK$$Limit;
+#elif !defined(SL_PORT_HOST)
+    /* GCC 链接脚本（CubeMX）：栈从 _estack 向下生长，保留 _Min_Stack_Size 字节，
+     * _end 与栈之间是堆，不能填充；链接脚本未定义 _Min_Stack_Size 时区间为空，不做栈检查 */
+    extern uint32_t _estack[];
+    extern sl_weak uint8_t _Min_Stack_Size[];
+
+    *top = _estack;
+
+    *bottom = _estack - (uintptr_t)_Min_Stack_Size / 4;
+#endif
+}
+
+/* 填充栈，须在系统初始化时尽早调用 */
+static void stack_paint(void)
+{
+    volatile uint32_t mark;
+
+    sl_stack_region(&stack_bottom, &stack_top);
+
+    /* 当前位置以下留出余量，不改写本函数的栈帧 */
+    uint32_t *end = (uint32_t *)((uintptr_t)&mark - 64);
+
+    for (uint32_t *p = stack_bottom; p < end; p++)
+        *p = STACK_PAINT;
+
+    sl_mem.stack_size = (stack_top - stack_bottom) * 4;
+}
+
+/* 从栈底向上找到第一个被改写的字，更新栈峰值 */
+static void stack_check(void)
+{
+    uint32_t *p = stack_bottom;
+
+    while (p < stack_top && *p == STACK_PAINT)
+        p++;
+
+    sl_mem.stack_peak = (stack_top - p) * 4;
+
+    /* 剩余不足 1/8 时警告，每 10s 最多一次 */
+    if (sl_mem.stack_size - sl_mem.stack_peak < sl_mem.stack_size / 8)
+        sl_error_ratelimit(10000, "stack nearly full, peak %d / %d bytes", (int)sl_mem.stack_peak, (int)sl_mem.stack_size);
+}
+
+#endif
+
+/* ============================================================== */
+
+/* 在 SRAM 中执行的代码字节数（sl_ramfunc），默认取 project.sct 中的 RW_IRAM_FUNC 区，
+ * GCC 取链接脚本中 .RamFunc 段前后的 _sramfunc / _eramfunc，未定义时为 0 */
+sl_weak uint32_t sl_ramfunc_size(void)
+{
+#if defined(__ARMCC_VERSION)
+    extern char Image$$RW_IRAM_FUNC$$Length[] __attribute__((weak));
+
+    return (uint32_t)Image$$RW_IRAM_FUNC$$Length;
+#elif !defined(SL_PORT_HOST)
+    extern char _sramfunc[] __attribute__((weak));
+    extern char _eramfunc[] __attribute__((weak));
+
+    return _eramfunc - _sramfunc;
+#else
+    return 0;
+#endif
+}
+
+/* 打印栈与注册表峰值 */
+void sl_mem_report(void)
+{
+#if SL_STACK_CHECK_ENABLE
+    stack_check();
+
+    sl_printf("stack peak %d / %d bytes", (int)sl_mem.stack_peak, (int)sl_mem.stack_size);
+#endif
+
+#if SL_RAMFUNC_ENABLE
+    sl_printf("ramfunc %d bytes", (int)sl_ramfunc_size());
+#endif
+
+    /* 每条不超过 8 个参数，异步文本日志只渲染前 8 个 */
+    sl_printf("timeout %d/%d, cycle %d/%d, multiple %d/%d",
+              sl_mem.timeout, SL_TIMEOUT_LIMIT, sl_mem.cycle, SL_CYCLE_LIMIT, sl_mem.multiple, SL_MULTIPLE_LIMIT);
+
+    sl_printf("parallel %d/%d, once %d/%d", sl_mem.parallel, SL_PARALLEL_LIMIT, sl_mem.once, SL_ONCE_LIMIT);
+
+    sl_printf("flow child %d/%d, sem wait %d/%d, scope var %d/%d",
+              sl_mem.flow_child, SL_FLOW_CHILD_LIMIT, sl_mem.sem_wait, SL_SEM_WAIT_LIMIT, sl_mem.scope_var, SL_SCOPE_VAR_LIMIT);
+}
+
+/* 栈填充，在 sloop_init 开头调用 */
+void sl_mem_paint(void)
+{
+#if SL_STACK_CHECK_ENABLE
+    stack_paint();
+#endif
+}
+
+/* 启动周期检查与报告，在 sloop_init 中调用 */
+void sl_mem_init(void)
+{
+#if SL_STACK_CHECK_ENABLE
+    sl_cycle_start(STACK_CHECK_MS, stack_check);
+#endif
+
+#if SL_MEM_REPORT_MS
+    sl_cycle_start(SL_MEM_REPORT_MS, sl_mem_report);
+
+    sl_shed_set(sl_mem_report, SL_SHED_STRETCH);
+#endif
+}
+
+/************************** END OF FILE **************************/
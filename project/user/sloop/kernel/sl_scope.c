@@ -0,0 +1,262 @@
+/**
+ ******************************************************************************
+ * @file    sl_scope
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   变量示波：在 tick 中断中按固定周期采样已登记变量，二进制写入 RTT 遥测通道
+ *          主机端使用 tools/sl_scope.py 导出 CSV
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+#if SL_SCOPE_ENABLE
+
+/*
+ * 帧格式（小端，无对齐）：
+ * 布局帧  [0x5C][变量数 n][采样周期 ms，2 字节][n × (类型, 名称长度, 名称)]
+ * 采样帧  [0xA5][tick 低 16 位][各变量按登记顺序、按类型宽度紧凑排列]
+ *
+ * 遥测通道只由 tick 中断写入，无需加锁；每帧一次写入，通道满时整帧丢弃。
+ * 登记变化后先补发布局帧，补发成功前不输出采样帧，主机端始终能按布局解析。
+ */
+
+#define SCOPE_LAYOUT 0x5C
+#define SCOPE_SAMPLE 0xA5
+
+/* 布局帧中名称的最大长度，超出截断 */
+#define SCOPE_NAME_MAX 16
+
+typedef struct
+{
+    volatile void *addr;
+
+    const char *name;
+
+    uint8_t type;
+
+} scope_typ;
+
+/* 已登记变量 */
+static scope_typ scope_reg[SL_SCOPE_VAR_LIMIT];
+
+static int scope_num;
+
+/* 采样周期 ms，0 为停止 */
+static uint16_t scope_period;
+
+/* 距上次采样的 ms 数 */
+static uint16_t scope_count;
+
+/* 登记变化，需补发布局帧 */
+static char scope_layout;
+
+/* 通道满丢弃的采样帧数，可在调试器中查看 */
+static uint32_t scope_drop;
+
+/* 各类型字节数 */
+static const uint8_t scope_size[] = {
+    [SL_SCOPE_U8] = 1,
+    [SL_SCOPE_S8] = 1,
+    [SL_SCOPE_U16] = 2,
+    [SL_SCOPE_S16] = 2,
+    [SL_SCOPE_U32] = 4,
+    [SL_SCOPE_S32] = 4,
+    [SL_SCOPE_F32] = 4,
+};
+
+/* ============================================================== */
+
+/* 登记变量，已登记则更新名称与类型，成功返回 1 */
+char sl_scope_add(const char *name, volatile void *addr, int type)
+{
+    int i;
+
+    for (i = 0; i < scope_num; i++)
+    {
+        if (scope_reg[i].addr == addr)
+            break;
+    }
+
+    if (i >= SL_SCOPE_VAR_LIMIT)
+    {
+        sl_error("scope var overflow, limit %2d", SL_SCOPE_VAR_LIMIT);
+
+        return 0;
+    }
+
+    /* 采样在中断中进行，修改登记表期间关中断 */
+    __disable_irq();
+
+    scope_reg[i].addr = addr;
+
+    scope_reg[i].name = name;
+
+    scope_reg[i].type = type;
+
+    if (i == scope_num)
+        scope_num++;
+
+    sl_mem_peak(scope_var, i);
+
+    scope_layout = 1;
+
+    __enable_irq();
+
+    return 1;
+}
+
+/* 移除变量 */
+void sl_scope_remove(volatile void *addr)
+{
+    __disable_irq();
+
+    for (int i = 0; i < scope_num; i++)
+    {
+        if (scope_reg[i].addr != addr)
+            continue;
+
+        for (; i < scope_num - 1; i++)
+            scope_reg[i] = scope_reg[i + 1];
+
+        scope_num--;
+
+        scope_layout = 1;
+
+        break;
+    }
+
+    __enable_irq();
+}
+
+/* 开始采样，每 ms 毫秒一次 */
+void sl_scope_start(int ms)
+{
+    __disable_irq();
+
+    scope_period = (ms > 0) ? ms : 1;
+
+    scope_count = 0;
+
+    scope_layout = 1;
+
+    __enable_irq();
+}
+
+/* 停止采样 */
+void sl_scope_stop(void)
+{
+    scope_period = 0;
+}
+
+/* ============================================================== */
+
+/* 发送布局帧，通道满返回 0 */
+static char scope_send_layout(void)
+{
+    uint8_t frame[4 + SL_SCOPE_VAR_LIMIT * (2 + SCOPE_NAME_MAX)];
+
+    uint8_t *p = frame;
+
+    *p++ = SCOPE_LAYOUT;
+
+    *p++ = scope_num;
+
+    *p++ = scope_period;
+
+    *p++ = scope_period >> 8;
+
+    for (int i = 0; i < scope_num; i++)
+    {
+        int len = strlen(scope_reg[i].name);
+
+        if (len > SCOPE_NAME_MAX)
+            len = SCOPE_NAME_MAX;
+
+        *p++ = scope_reg[i].type;
+
+        *p++ = len;
+
+        memcpy(p, scope_reg[i].name, len);
+
+        p += len;
+    }
+
+    return SEGGER_RTT_WriteNoLock(SL_RTT_CH_TELE, frame, p - frame) != 0;
+}
+
+/* 采样，在 tick 中断中每 ms 调用一次 */
+void sl_scope_sample(void)
+{
+    if (scope_period == 0 || ++scope_count < scope_period)
+        return;
+
+    scope_count = 0;
+
+    if (scope_layout)
+    {
+        if (scope_send_layout() == 0)
+            return;
+
+        scope_layout = 0;
+    }
+
+    uint8_t frame[3 + SL_SCOPE_VAR_LIMIT * 4];
+
+    uint8_t *p = frame;
+
+    uint32_t tick = sl_get_tick();
+
+    *p++ = SCOPE_SAMPLE;
+
+    *p++ = tick;
+
+    *p++ = tick >> 8;
+
+    /* 按类型宽度单次读取，同一变量不会读到一半新一半旧的值 */
+    for (int i = 0; i < scope_num; i++)
+    {
+        volatile void *addr = scope_reg[i].addr;
+
+        switch (scope_size[scope_reg[i].type])
+        {
+        case 1:
+            *p++ = *(volatile uint8_t *)addr;
+            break;
+
+        case 2:
+        {
+            uint16_t v = *(volatile uint16_t *)addr;
+
+            *p++ = v;
+
+            *p++ = v >> 8;
+            break;
+        }
+
+        default:
+        {
+            uint32_t v = *(volatile uint32_t *)addr;
+
+            *p++ = v;
+
+            *p++ = v >> 8;
+
+            *p++ = v >> 16;
+
+            *p++ = v >> 24;
+            break;
+        }
+        }
+    }
+
+    if (SEGGER_RTT_WriteNoLock(SL_RTT_CH_TELE, frame, p - frame) == 0)
+        scope_drop++;
+}
+
+#endif
+
+/************************** END OF FILE **************************/
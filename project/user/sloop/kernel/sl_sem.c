@@ -0,0 +1,259 @@
+/**
+ ******************************************************************************
+ * @file    sl_sem
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   协作式信号量/互斥量，供 Flow 与互斥任务共享外设
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+/* 互斥任务作为等待者/持有者时的标识 */
+uint32_t sl_sem_task_id;
+
+/* 已使用的信号量链表，Flow 退出时据此清理 */
+static sl_sem_typ *sem_list;
+
+/* ============================================================== */
+
+/* 登记到信号量链表 */
+static void sem_link(sl_sem_typ *sem)
+{
+    if (sem->linked)
+        return;
+
+    sem->next = sem_list;
+
+    sem_list = sem;
+
+    sem->linked = 1;
+}
+
+/* 查找等待者位置，未排队返回 -1 */
+static int sem_find(sl_sem_typ *sem, uint32_t *id)
+{
+    for (int i = 0; i < sem->wait_num; i++)
+    {
+        if (sem->wait_id[i] == id)
+            return i;
+    }
+
+    return -1;
+}
+
+/* 按唤醒顺序排队，队列已满返回 0 */
+static char sem_enqueue(sl_sem_typ *sem, uint32_t *id, int prio)
+{
+    if (sem->wait_num >= SL_SEM_WAIT_LIMIT)
+        return 0;
+
+    int pos = sem->wait_num;
+
+    /* 优先级顺序：插到同级等待者之后，同级保持先来先得 */
+    if (sem->order == SL_SEM_PRIO)
+    {
+        while (pos > 0 && sem->wait_prio[pos - 1] > prio)
+        {
+            sem->wait_id[pos] = sem->wait_id[pos - 1];
+
+            sem->wait_prio[pos] = sem->wait_prio[pos - 1];
+
+            pos--;
+        }
+    }
+
+    sem->wait_id[pos] = id;
+
+    sem->wait_prio[pos] = prio;
+
+    sem->wait_num++;
+
+    if (sem->wait_num > sem->wait_max)
+        sem->wait_max = sem->wait_num;
+
+    sl_mem_peak(sem_wait, sem->wait_num - 1);
+
+    return 1;
+}
+
+/* 移出等待队列 */
+static void sem_dequeue(sl_sem_typ *sem, int pos)
+{
+    for (int i = pos; i < sem->wait_num - 1; i++)
+    {
+        sem->wait_id[i] = sem->wait_id[i + 1];
+
+        sem->wait_prio[i] = sem->wait_prio[i + 1];
+    }
+
+    sem->wait_num--;
+}
+
+/* ============================================================== */
+
+/*
+ * 尝试获取，未获取则排队，仅队首可获取。等待者不会被释放者唤醒，由调用者每轮主循环重新尝试：
+ * 返回 1 获取成功，0 继续等待，SL_SEM_FAIL 本次获取失败（只报告一次，调用者须停止等待）
+ */
+int sl_sem_try(sl_sem_typ *sem, uint32_t *id, int prio)
+{
+    int pos = sem_find(sem, id);
+
+    if (sem->mutex && sem->owner == id)
+    {
+        sl_error("mutex cannot be taken nested");
+
+        return SL_SEM_FAIL;
+    }
+
+    /* 有人排队时只有队首可获取，保证唤醒顺序 */
+    if (sem->count > 0 && (sem->wait_num == 0 || pos == 0))
+    {
+        __disable_irq();
+
+        sem->count--;
+
+        __enable_irq();
+
+        if (pos == 0)
+            sem_dequeue(sem, 0);
+
+        if (sem->mutex)
+        {
+            sem_link(sem);
+
+            sem->owner = id;
+
+            sem->owner_tick = sl_get_tick();
+        }
+
+        return 1;
+    }
+
+    if (pos < 0)
+    {
+        sem_link(sem);
+
+        if (sem_enqueue(sem, id, prio) == 0)
+        {
+            sl_error("sem wait overflow, limit %2d", SL_SEM_WAIT_LIMIT);
+
+            return SL_SEM_FAIL;
+        }
+    }
+
+    return 0;
+}
+
+/* 退出等待队列 */
+static void sem_leave(sl_sem_typ *sem, uint32_t *id)
+{
+    int pos = sem_find(sem, id);
+
+    if (pos >= 0)
+        sem_dequeue(sem, pos);
+}
+
+/* 超时放弃等待，计入超时次数 */
+void sl_sem_cancel(sl_sem_typ *sem, uint32_t *id)
+{
+    sem_leave(sem, id);
+
+    sem->timeout_count++;
+
+    if (sem->mutex && sem->owner != NULL)
+    {
+        sl_error("mutex take timeout, owner 0x%p held %d ms", sem->owner, (int)(sl_get_tick() - sem->owner_tick));
+    }
+}
+
+/* 释放 */
+void sl_sem_release(sl_sem_typ *sem, uint32_t *id)
+{
+    if (sem->mutex)
+    {
+        if (sem->owner != id)
+        {
+            sl_error("mutex released by non-owner, owner 0x%p", sem->owner);
+
+            return;
+        }
+
+        uint32_t hold = sl_get_tick() - sem->owner_tick;
+
+        if (hold > sem->hold_max)
+            sem->hold_max = hold;
+
+        sem->owner = NULL;
+    }
+
+    /* 可在中断中调用 */
+    __disable_irq();
+
+    if (sem->count < sem->max)
+        sem->count++;
+
+    __enable_irq();
+}
+
+/* Flow 退出时，退出全部等待队列并释放其持有的互斥量 */
+void sl_sem_drop(uint32_t *id)
+{
+    for (sl_sem_typ *sem = sem_list; sem != NULL; sem = sem->next)
+    {
+        sem_leave(sem, id);
+
+        if (sem->mutex && sem->owner == id)
+        {
+            sl_error("flow exit with mutex held, release it");
+
+            sl_sem_release(sem, id);
+        }
+    }
+}
+
+/* ============================================================== */
+
+/* 互斥任务获取信号量/互斥量，等待期间并行任务照常运行 */
+char sl_sem_take(sl_sem_typ *sem, int ms)
+{
+    uint32_t tick_start = sl_get_tick();
+
+    while (1)
+    {
+        int r = sl_sem_try(sem, &sl_sem_task_id, SL_PRIO_DEFAULT);
+
+        if (r == SL_SEM_FAIL)
+            return 0;
+
+        if (r)
+            return 1;
+
+        /* 运行一轮并行任务，等待被中断（任务切换）时放弃，不计为超时 */
+        if (sl_wait(0))
+        {
+            sem_leave(sem, &sl_sem_task_id);
+
+            return 0;
+        }
+
+        if (ms >= 0 && (uint32_t)(sl_get_tick() - tick_start) >= ms)
+            break;
+    }
+
+    sl_sem_cancel(sem, &sl_sem_task_id);
+
+    return 0;
+}
+
+/* 释放信号量/互斥量 */
+void sl_sem_give(sl_sem_typ *sem)
+{
+    sl_sem_release(sem, &sl_sem_task_id);
+}
+
+/************************** END OF FILE **************************/
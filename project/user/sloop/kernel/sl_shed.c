@@ -0,0 +1,242 @@
+/**
+ ******************************************************************************
+ * @file    sl_shed
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   过载降级：负载持续偏高时拉长或暂停声明为低优先级的周期任务，暂停可选的并行任务，
+ *          负载回落后带迟滞地恢复，突发负载下先牺牲诊断，保住控制
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+#if SL_SHED_ENABLE
+
+/*
+ * 每个负载统计窗口（100ms）结束时由 sl_load.c 调用 sl_shed_update：
+ * 负载持续 SL_SHED_HOLD_MS 高于 SL_SHED_ON 进入降级，持续 SL_SHED_HOLD_MS 低于 SL_SHED_OFF 恢复，
+ * 阈值与持续时间双重迟滞，突发的单个窗口不会来回切换。
+ *
+ * 降级只作用于 sl_shed_set 声明过的任务，未声明的任务（控制类）不受影响：
+ * 周期任务到期时照常开始下一周期，STRETCH 类每 SL_SHED_FACTOR 个周期只运行一次，PAUSE 类不运行；
+ * 并行任务不论类别都从注册表中暂时移出，恢复时重新登记，降级期间不占用主循环的轮询时间。
+ * 降级期间 sl_task_start 的已声明任务同样暂缓登记，sl_task_stop 则取消其恢复。
+ */
+
+/* 降级声明 */
+typedef struct
+{
+    pfunc task;
+
+    uint8_t cls;
+
+    /* STRETCH 类周期任务跳过的周期数 */
+    uint8_t skip;
+
+    /* 并行任务已暂时移出，恢复时重新登记 */
+    char parked;
+
+} shed_typ;
+
+static shed_typ shed_reg[SL_SHED_LIMIT];
+
+/* 处于降级状态 */
+static char shedding;
+
+/* 负载开始越过进入/恢复阈值的时刻 */
+static uint32_t shed_since;
+
+/* 是否已登记为并行任务，见 sloop.c */
+char sl_task_running(pfunc task);
+
+/* ============================================================== */
+
+static shed_typ *shed_find(pfunc task)
+{
+    for (int i = 0; i < SL_SHED_LIMIT; i++)
+    {
+        if (shed_reg[i].task == task)
+            return &shed_reg[i];
+    }
+
+    return NULL;
+}
+
+/* 暂时移出并行任务 */
+static void shed_park(shed_typ *e)
+{
+    if (sl_task_running(e->task) == 0)
+        return;
+
+    sl_task_stop(e->task);
+
+    e->parked = 1;
+}
+
+/* 重新登记暂时移出的并行任务 */
+static void shed_unpark(shed_typ *e)
+{
+    if (e->parked == 0)
+        return;
+
+    e->parked = 0;
+
+    sl_task_start(e->task);
+}
+
+/* 进入/退出降级 */
+static void shed_switch(char on, uint32_t load)
+{
+    shedding = on;
+
+    for (int i = 0; i < SL_SHED_LIMIT; i++)
+    {
+        shed_typ *e = &shed_reg[i];
+
+        if (e->task == NULL)
+            continue;
+
+        e->skip = 0;
+
+        on ? shed_park(e) : shed_unpark(e);
+    }
+
+    if (on)
+        sl_warn("load shedding on, load %2d.%d%%", load / 10, load % 10);
+    else
+        sl_printf("load shedding off, load %2d.%d%%", load / 10, load % 10);
+}
+
+/* 每个负载统计窗口结束时调用，load 单位 0.1% */
+void sl_shed_update(uint32_t load)
+{
+    uint32_t now = sl_get_tick();
+
+    /* 未越过阈值时重新计时 */
+    if (shedding ? load >= SL_SHED_OFF : load <= SL_SHED_ON)
+    {
+        shed_since = now;
+
+        return;
+    }
+
+    if ((uint32_t)(now - shed_since) < SL_SHED_HOLD_MS)
+        return;
+
+    shed_since = now;
+
+    shed_switch(!shedding, load);
+}
+
+/* 周期任务到期时调用，返回 1 表示本周期跳过 */
+char sl_shed_skip(pfunc task)
+{
+    if (shedding == 0)
+        return 0;
+
+    shed_typ *e = shed_find(task);
+
+    if (e == NULL)
+        return 0;
+
+    if (e->cls == SL_SHED_PAUSE)
+        return 1;
+
+    /* STRETCH：每 SL_SHED_FACTOR 个周期运行一次 */
+    if (++e->skip < SL_SHED_FACTOR)
+        return 1;
+
+    e->skip = 0;
+
+    return 0;
+}
+
+/* sl_task_start 时调用：降级期间已声明的任务暂缓登记，返回 1 */
+char sl_shed_hold(pfunc task)
+{
+    if (shedding == 0)
+        return 0;
+
+    shed_typ *e = shed_find(task);
+
+    if (e == NULL)
+        return 0;
+
+    e->parked = 1;
+
+    return 1;
+}
+
+/* sl_task_stop 时调用：取消暂时移出任务的恢复 */
+void sl_shed_drop(pfunc task)
+{
+    shed_typ *e = shed_find(task);
+
+    if (e != NULL)
+        e->parked = 0;
+}
+
+/* 声明任务的降级类别，SL_SHED_NONE 为取消声明 */
+void sl_shed_set(pfunc task, char cls)
+{
+    if (task == NULL)
+    {
+        sl_error("The task is null");
+
+        return;
+    }
+
+    shed_typ *e = shed_find(task);
+
+    if (cls == SL_SHED_NONE)
+    {
+        if (e == NULL)
+            return;
+
+        char parked = e->parked;
+
+        e->task = NULL;
+
+        if (parked)
+            sl_task_start(task);
+
+        return;
+    }
+
+    if (e == NULL)
+    {
+        e = shed_find(NULL);
+
+        if (e == NULL)
+        {
+            sl_error("shed task overflow, limit %2d", SL_SHED_LIMIT);
+
+            return;
+        }
+
+        e->task = task;
+
+        e->skip = 0;
+
+        e->parked = 0;
+    }
+
+    e->cls = cls;
+
+    /* 降级期间声明的并行任务立即移出 */
+    if (shedding)
+        shed_park(e);
+}
+
+/* 当前是否处于降级状态 */
+char sl_shed_active(void)
+{
+    return shedding;
+}
+
+#endif
+
+/************************** END OF FILE **************************/
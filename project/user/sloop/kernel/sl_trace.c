@@ -0,0 +1,167 @@
+/**
+ ******************************************************************************
+ * @file    sl_trace
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   Flow 状态迁移跟踪：记录写入 RAM 环形缓冲，空闲时经独立 RTT 通道输出
+ *          主机端使用 tools/sl_trace.py 转换为 Chrome/Perfetto 时间线
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
+#include "sloop.h"
+
+#if SL_TRACE_ENABLE
+
+#if SL_TRACE_NUM & (SL_TRACE_NUM - 1)
+#error "SL_TRACE_NUM must be a power of 2"
+#endif
+
+/* 头记录标识 'SLTR'，头记录的 why，以及丢失记录的 why（tick 为丢失条数） */
+#define SL_TRACE_MAGIC 0x534C5452
+#define SL_TRACE_HEADER 0xFF
+#define SL_TRACE_LOST 0xFE
+
+/* 当前 ms 内的 SysTick 计数，用于亚毫秒时间戳，每 ms 计数超过 16 位时右移 trace_shift 位 */
+#ifndef SL_TRACE_SUB
+#define SL_TRACE_SUB() (uint16_t)((SysTick->LOAD - SysTick->VAL) >> trace_shift)
+#endif
+
+/* 跟踪记录，16 字节 */
+typedef struct
+{
+    /* 时间戳 ms */
+    uint32_t tick;
+
+    /* ms 内 SysTick 计数 */
+    uint16_t sub;
+
+    /* 原状态 */
+    uint16_t from;
+
+    /* Flow 标识：状态变量地址 */
+    uint32_t flow;
+
+    /* 新状态 */
+    uint16_t to;
+
+    /* 挂起原因 FLOW_WHY_xxx */
+    uint8_t why;
+
+    /* 序号低8位，主机据此检测丢失 */
+    uint8_t seq;
+
+} trace_typ;
+
+/* 跟踪 RAM 环形缓冲，溢出时覆盖最旧记录，停机后可在调试器中查看 */
+static trace_typ trace_ring[SL_TRACE_NUM];
+
+/* 读写序号（自由递增） */
+static uint32_t trace_wr;
+static uint32_t trace_rd;
+
+/* 被覆盖、尚未报告给主机的记录数 */
+static uint32_t trace_lost;
+
+/* 亚毫秒计数右移位数 */
+static uint8_t trace_shift;
+
+/* ============================================================== */
+
+/* 记录一次 Flow 状态迁移，仅在主循环上下文调用，无需加锁 */
+void sl_trace_flow(uint32_t *flow, uint32_t from, uint32_t to, uint8_t why)
+{
+    trace_typ *t = &trace_ring[trace_wr & (SL_TRACE_NUM - 1)];
+
+    t->tick = sl_get_tick();
+
+    t->sub = SL_TRACE_SUB();
+
+    t->from = from;
+
+    t->flow = (uint32_t)(uintptr_t)flow;
+
+    t->to = to;
+
+    t->why = why;
+
+    t->seq = trace_wr;
+
+    trace_wr++;
+}
+
+/* 将未发出的记录写入 RTT 通道 */
+static void trace_drain(void)
+{
+    /* 已被覆盖的记录直接跳过 */
+    if (trace_wr - trace_rd > SL_TRACE_NUM)
+    {
+        trace_lost += trace_wr - trace_rd - SL_TRACE_NUM;
+
+        trace_rd = trace_wr - SL_TRACE_NUM;
+    }
+
+    /* 丢失条数先于其后的记录发出，通道满时下次再报 */
+    if (trace_lost)
+    {
+        trace_typ lost = {trace_lost, 0, 0, SL_TRACE_MAGIC, 0, SL_TRACE_LOST, 0};
+
+        if (SEGGER_RTT_Write(SL_RTT_CH_TRACE, &lost, sizeof lost) == 0)
+            return;
+
+        trace_lost = 0;
+    }
+
+    while (trace_rd != trace_wr)
+    {
+        /* 通道满时整条跳过写入，记录留在 RAM 中下次再发 */
+        if (SEGGER_RTT_Write(SL_RTT_CH_TRACE, &trace_ring[trace_rd & (SL_TRACE_NUM - 1)], sizeof(trace_typ)) == 0)
+            break;
+
+        trace_rd++;
+    }
+}
+
+/* 按当前时钟确定亚毫秒计数的右移位数，返回头记录：tick 为右移后的每 ms 计数，供主机换算亚毫秒时间 */
+static trace_typ trace_header(void)
+{
+    trace_shift = 0;
+
+    while ((SysTick->LOAD >> trace_shift) > 0xFFFF)
+        trace_shift++;
+
+    trace_typ head = {(SysTick->LOAD + 1) >> trace_shift, 0, 0, SL_TRACE_MAGIC, 0, SL_TRACE_HEADER, 0};
+
+    return head;
+}
+
+#if SL_GOV_ENABLE
+
+/* 调频后调用：头记录写入环形缓冲，排在切换前的记录之后，主机此后按新的每 ms 计数换算 */
+void sl_trace_clock(void)
+{
+    trace_ring[trace_wr & (SL_TRACE_NUM - 1)] = trace_header();
+
+    trace_wr++;
+}
+
+#endif
+
+/* 跟踪初始化 */
+void sl_trace_init(void)
+{
+    trace_typ head = trace_header();
+
+    SEGGER_RTT_Write(SL_RTT_CH_TRACE, &head, sizeof head);
+
+    sl_cycle_start(10, trace_drain);
+
+    /* 过载时拉长输出周期，记录留在环形缓冲中，溢出时主机端可见丢失 */
+    sl_shed_set(trace_drain, SL_SHED_STRETCH);
+}
+
+#endif
+
+/************************** END OF FILE **************************/
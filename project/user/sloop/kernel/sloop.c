@@ -8,6 +8,8 @@
  * ==此文件用户不应变更==
  *****************************************************************************/
 
+#define SL_LOG_MODULE SL_MOD_KERNEL
+
 #include "sloop.h"
 
 #define sl_check_task_not_null()      \
@@ -23,6 +25,8 @@
 
 void print_null(const char *sFormat, ...) {}
 
+/* 以下调度热路径标记为 sl_ramfunc，SL_RAMFUNC_ENABLE 时在 SRAM 中执行 */
+
 /* 超时任务运行 */
 void timeout_run(void);
 /* 周期任务运行 */
@@ -42,26 +46,87 @@ void soft_timer(void);
 
 /* 系统心跳 */
 void system_heartbeat(void);
-/* 计数循环次数 */
-void loop_counter(void);
-/* 计算 cpu 负载 */
-void calcul_cpu_load(void);
-/* 负载警告 */
-void load_warning(void);
+/* 每轮主循环计数与计时 */
+void sl_load_loop(void);
+/* CPU 负载统计初始化 */
+void sl_load_init(void);
+/* 投递 soft_timer 时记录时刻 */
+void sl_latency_tick(void);
+/* soft_timer 运行时记录延迟 */
+void sl_latency_timer(void);
+
+/* 栈填充 */
+void sl_mem_paint(void);
+/* 栈检查与峰值报告初始化 */
+void sl_mem_init(void);
+
+/* RTT 通道布局初始化 */
+void sl_rtt_init(void);
+/* 变量示波采样 */
+void sl_scope_sample(void);
+/* Flow 跟踪初始化 */
+void sl_trace_init(void);
+/* 异步日志初始化 */
+void sl_log_init(void);
+/* 日志限频/去重初始化 */
+void sl_log_limit_init(void);
+/* UART 日志后端初始化 */
+void sl_log_uart_init(void);
+
+#if SL_SHED_ENABLE
+/* 过载降级：周期任务本周期是否跳过 / 并行任务是否暂缓登记 / 取消暂缓 */
+char sl_shed_skip(pfunc task);
+char sl_shed_hold(pfunc task);
+void sl_shed_drop(pfunc task);
+#endif
 
 static volatile uint32_t tick;
 
-static int loop;
+#if SL_LOAD_TASK_NUM
+
+/* 调用任务并计时，统计各任务占比。poll 为 1 表示每轮都轮询的任务（并行/互斥任务） */
+#define sl_task_call(task, poll)           \
+    do                                     \
+    {                                      \
+        sl_load_frame_typ _frame;          \
+        sl_load_enter(&_frame);            \
+        task();                            \
+        sl_load_exit(&_frame, task, poll); \
+    } while (0)
+
+/* 等待期间的轮询计为空闲，从当前任务的执行时间中扣除 */
+#define sl_load_idle_begin() \
+    sl_load_frame_typ _idle; \
+    sl_load_enter(&_idle)
+
+#define sl_load_idle_end() sl_load_exit(&_idle, NULL, 0)
+
+#else
 
-static int load;
+#define sl_task_call(task, poll) task()
+#define sl_load_idle_begin()
+#define sl_load_idle_end()
 
-static int loop_us;
+#endif
 
 /* ============================================================== */
 
 /* sloop 系统初始化 */
 void sloop_init(void)
 {
+    /* 填充栈，此后可统计栈峰值 */
+    sl_mem_paint();
+
+#if SL_RTT_ENABLE
+    /* 配置 RTT 各通道缓冲区 */
+    sl_rtt_init();
+#endif
+
+#if SL_BENCH_ENABLE
+    /* 调度器微基准，须在登记系统任务之前运行 */
+    sl_bench_run();
+#endif
+
     sl_prt_brYellow("==================================");
     sl_prt_brYellow("========= sloop  (^-^) ==========");
     sl_prt_brYellow("==================================");
@@ -69,20 +134,38 @@ void sloop_init(void)
     /* 启用单次任务 */
     sl_task_start(once_task_run);
 
-    /* 启动 loop 计数 */
-    sl_task_start(loop_counter);
+    /* 启动 cpu 负载统计 */
+    sl_load_init();
 
-    /* 启动 cpu 负载计算 */
-    sl_cycle_start(100, calcul_cpu_load);
+    /* 启动栈检查 */
+    sl_mem_init();
 
     /* 启用系统心跳 */
     sl_cycle_start(1000, system_heartbeat);
 
+    /* 启用日志重复次数汇总 */
+    sl_log_limit_init();
+
+#if SL_TRACE_ENABLE
+    /* 启用 Flow 跟踪 */
+    sl_trace_init();
+#endif
+
+#if SL_LOG_DEFER && SL_LOG_ASYNC
+    /* 启用异步日志输出 */
+    sl_log_init();
+#endif
+
+#if SL_RTT_ENABLE && SL_LOG_BACKEND == SL_BACKEND_UART
+    /* 启用 UART 日志后端 */
+    sl_log_uart_init();
+#endif
+
     sl_printf("system heartbeat start");
 }
 
 /* sloop 系统运行 */
-void sloop(void)
+sl_ramfunc void sloop(void)
 {
     /* 互斥任务运行 */
     mutex_task_run();
@@ -94,17 +177,31 @@ void sloop(void)
 /* ============================================================== */
 
 /* mcu tick 中断 */
-void sl_tick_irq(void)
+sl_ramfunc void sl_tick_irq(void)
 {
     tick++;
 
+#if SL_SCOPE_ENABLE
+    /* 变量示波采样，在中断中进行以保证采样间隔 */
+    sl_scope_sample();
+#endif
+
+#if SL_LATENCY_ENABLE
+    /* 记录投递时刻，统计到 soft_timer 运行的延迟 */
+    sl_latency_tick();
+#endif
+
     /* 软件定时器 1ms 启动一次 */
     sl_task_once(soft_timer);
 }
 
 /* 软件定定时器 */
-void soft_timer(void)
+sl_ramfunc void soft_timer(void)
 {
+#if SL_LATENCY_ENABLE
+    sl_latency_timer();
+#endif
+
     /* 超时任务运行 */
     timeout_run();
 
@@ -122,76 +219,70 @@ void system_heartbeat(void)
 {
     static int count;
 
-    SEGGER_RTT_SetTerminal(1);
-
     sl_prt_var(count);
 
-    SEGGER_RTT_SetTerminal(0);
-
     count++;
 }
 
 /* ============================================================== */
 
-/* CPU 负载基数，即 CPU = 100% 时，一个 loop 的时间 单位0.1us，约定当loop 达到100us时，CPU 占用为100% */
-#define LOOP_BASE 1000
-
-/* 计数循环次数 */
-void loop_counter(void)
+/* 获取时间戳 */
+sl_ramfunc uint32_t sl_get_tick(void)
 {
-    loop++;
+    return tick;
 }
 
-/* 计算 cpu 负载 */
-void calcul_cpu_load(void)
-{
-    if (loop == 0)
-        return;
+#if SL_GOV_ENABLE
+
+/* 周期计数偏移，调频后 SysTick 每 ms 计数改变，保持周期计数连续 */
+static uint32_t cycle_base;
+
+#else
 
-    static char warning;
+#define cycle_base 0
 
-    loop_us = 1000000 / loop;
+#endif
 
-    load = loop_us * 1000 / LOOP_BASE;
+/* 获取周期计数时间戳（自由回绕），由 tick 与 SysTick 计数合成，带 DWT 的内核可重新实现 */
+sl_weak sl_ramfunc uint32_t sl_get_cycle(void)
+{
+    uint32_t t;
 
-    loop = 0;
+    uint32_t val;
 
-    /* 负载超过 80% ,日志警告 */
-    if (warning == 0)
+    /* 读取期间发生 tick 中断则重读 */
+    do
     {
-        if (load > 800)
-        {
-            sl_cycle_start(1000, load_warning);
+        t = tick;
 
-            warning = 1;
-        }
+        val = SysTick->VAL;
 
-        return;
-    }
+    } while (t != tick);
 
-    /* 解除警告 */
-    if (load < 600)
+#if !defined(SL_PORT_HOST)
+    /* 关中断或更高优先级中断中，SysTick 已回绕而 tick 尚未累加：补上这 1ms。
+     * 挂起位可能在第一次读 VAL 之后才置位，重读 VAL 取回绕后的值 */
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
     {
-        sl_cycle_stop(load_warning);
+        val = SysTick->VAL;
 
-        warning = 0;
+        t++;
     }
-}
+#endif
 
-/* 负载警告 */
-void load_warning(void)
-{
-    sl_error("cpu load over 80%%, reach %2d.%d%%, average loop time: %d.%d us", load / 10, load % 10, loop_us / 10, loop_us % 10);
+    return cycle_base + t * (SysTick->LOAD + 1) + (SysTick->LOAD - val);
 }
 
-/* ============================================================== */
+#if SL_GOV_ENABLE
 
-/* 获取时间戳 */
-uint32_t sl_get_tick(void)
+/* 调频后调用（关中断），使周期计数从切换前的 before 继续 */
+void sl_cycle_rebase(uint32_t before)
 {
-    return tick;
+    cycle_base += before - sl_get_cycle();
 }
 
+#endif
+
 /* 阻塞式延时 */
 void sl_delay(int ms)
 {
@@ -206,11 +297,121 @@ void sl_delay(int ms)
         {
             return;
         }
+
+        /* 仿真时阻塞期间直接推进到延时结束 */
+        sl_sim_deadline(tick_start + ms);
+
+        sl_sim_round();
     }
 }
 
 /* ============================================================== */
 
+#if SL_TIMER_STAT_ENABLE
+
+#define TIMER_STAT_NUM (SL_TIMEOUT_LIMIT + SL_CYCLE_LIMIT + SL_MULTIPLE_LIMIT)
+
+/* 定时器迟到统计，依次为超时、周期、多次任务，与各自注册表一一对应 */
+static sl_timer_stat_typ timer_stat[TIMER_STAT_NUM];
+
+#define timeout_stat (timer_stat)
+#define cycle_stat (timer_stat + SL_TIMEOUT_LIMIT)
+#define multiple_stat (timer_stat + SL_TIMEOUT_LIMIT + SL_CYCLE_LIMIT)
+
+/* 登记定时器，同一任务重新登记到同一位置时保留统计 */
+static void timer_stat_init(sl_timer_stat_typ *stat, int type, int ms, pfunc task)
+{
+    if (stat->task != task || stat->type != type)
+    {
+        memset(stat, 0, sizeof *stat);
+
+        stat->task = task;
+
+        stat->type = type;
+
+        stat->min = UINT16_MAX;
+    }
+
+    stat->period = ms;
+}
+
+/* 记录一次触发的迟到 ms */
+static void timer_stat_record(sl_timer_stat_typ *stat, uint32_t late)
+{
+    if (late > UINT16_MAX)
+        late = UINT16_MAX;
+
+    stat->count++;
+
+    stat->sum += late;
+
+    if (late < stat->min)
+        stat->min = late;
+
+    if (late > stat->max)
+        stat->max = late;
+}
+
+/* 遍历定时器迟到统计，跳过未触发过的 */
+int sl_timer_stat_next(int it, sl_timer_stat_typ *stat)
+{
+    for (; it >= 0 && it < TIMER_STAT_NUM; it++)
+    {
+        if (timer_stat[it].count == 0)
+            continue;
+
+        *stat = timer_stat[it];
+
+        return it + 1;
+    }
+
+    return -1;
+}
+
+/* 打印各定时器迟到统计 */
+void sl_timer_report(void)
+{
+    /* 名称预先补齐到 8 字符：RTT 打印的 %s 不支持宽度 */
+    static const char *const name[] = {"timeout ", "cycle   ", "multiple"};
+
+    sl_timer_stat_typ stat;
+
+    for (int it = 0; (it = sl_timer_stat_next(it, &stat)) >= 0;)
+    {
+        /* 平均值保留一位小数 */
+        int avg = stat.sum / stat.count;
+
+        int frac = (stat.sum % stat.count) * 10 / stat.count;
+
+        sl_printf("%s %5d ms task 0x%p late min %d max %d avg %d.%d ms, %d runs",
+                  name[stat.type], stat.period, (void *)stat.task, stat.min, stat.max, avg, frac, (int)stat.count);
+    }
+}
+
+/* 清空定时器迟到统计，保留登记信息 */
+void sl_timer_stat_reset(void)
+{
+    for (int i = 0; i < TIMER_STAT_NUM; i++)
+    {
+        timer_stat[i].count = 0;
+
+        timer_stat[i].sum = 0;
+
+        timer_stat[i].min = UINT16_MAX;
+
+        timer_stat[i].max = 0;
+    }
+}
+
+#else
+
+#define timer_stat_init(stat, type, ms, task)
+#define timer_stat_record(stat, late)
+
+#endif
+
+/* ============================================================== */
+
 /* 超时任务数据 */
 typedef struct
 {
@@ -226,7 +427,7 @@ typedef struct
 static timeout_typ timeout_reg[SL_TIMEOUT_LIMIT];
 
 /* 超时任务运行 */
-void timeout_run(void)
+sl_ramfunc void timeout_run(void)
 {
     uint32_t tick_start;
     int delay_ms;
@@ -248,7 +449,9 @@ void timeout_run(void)
             /* 超时任务完成，释放资源 */
             timeout_reg[i].callback = NULL;
 
-            backup_reg[i].callback();
+            timer_stat_record(&timeout_stat[i], (uint32_t)(tick - tick_start) - delay_ms);
+
+            sl_task_call(backup_reg[i].callback, 0);
         }
     }
 }
@@ -283,6 +486,10 @@ void sl_timeout_start(int ms, pfunc task)
 
             timeout_reg[i].callback = task;
 
+            timer_stat_init(&timeout_stat[i], SL_TIMER_TIMEOUT, ms, task);
+
+            sl_mem_peak(timeout, i);
+
             return;
         }
     }
@@ -323,7 +530,7 @@ typedef struct
 static cycle_typ cycle_reg[SL_CYCLE_LIMIT];
 
 /* 周期任务运行 */
-void cycle_run(void)
+sl_ramfunc void cycle_run(void)
 {
     uint32_t tick_start;
     int delay_ms;
@@ -345,7 +552,15 @@ void cycle_run(void)
             /* 周期任务完成，更新时间戳，开启下一周期 */
             cycle_reg[i].tick_start = tick;
 
-            backup_reg[i].callback();
+            timer_stat_record(&cycle_stat[i], (uint32_t)(tick - tick_start) - delay_ms);
+
+#if SL_SHED_ENABLE
+            /* 过载降级中的低优先级任务 */
+            if (sl_shed_skip(backup_reg[i].callback))
+                continue;
+#endif
+
+            sl_task_call(backup_reg[i].callback, 0);
         }
     }
 }
@@ -380,6 +595,10 @@ void sl_cycle_start(int ms, pfunc task)
 
             cycle_reg[i].callback = task;
 
+            timer_stat_init(&cycle_stat[i], SL_TIMER_CYCLE, ms, task);
+
+            sl_mem_peak(cycle, i);
+
             /* 周期任务开始时，执行一次 */
             if (task != NULL)
                 task();
@@ -426,7 +645,7 @@ typedef struct
 static multiple_typ multiple_reg[SL_MULTIPLE_LIMIT];
 
 /* 多次任务运行 */
-void multiple_run(void)
+sl_ramfunc void multiple_run(void)
 {
     uint32_t tick_start;
     int delay_ms;
@@ -448,7 +667,9 @@ void multiple_run(void)
             /* 多次任务完成，更新时间戳，开启下一多次 */
             multiple_reg[i].tick_start = tick;
 
-            backup_reg[i].callback();
+            timer_stat_record(&multiple_stat[i], (uint32_t)(tick - tick_start) - delay_ms);
+
+            sl_task_call(backup_reg[i].callback, 0);
 
             multiple_reg[i].num--;
 
@@ -505,6 +726,10 @@ void sl_multiple_start(int num, int ms, pfunc task)
 
             multiple_reg[i].callback = task;
 
+            timer_stat_init(&multiple_stat[i], SL_TIMER_MULTIPLE, ms, task);
+
+            sl_mem_peak(multiple, i);
+
             /* 多次任务开始时，执行一次 */
             if (task != NULL)
                 task();
@@ -534,19 +759,110 @@ void sl_multiple_stop(pfunc task)
 
 /* ============================================================== */
 
+#if defined(SL_PORT_SIM)
+
+/* 登记全部软件定时器的到期时刻，虚拟时间仿真据此跳转 */
+void sl_timer_deadline(void)
+{
+    for (int i = 0; i < SL_TIMEOUT_LIMIT; i++)
+    {
+        if (timeout_reg[i].callback != NULL)
+            sl_sim_deadline(timeout_reg[i].tick_start + timeout_reg[i].delay_ms);
+    }
+
+    for (int i = 0; i < SL_CYCLE_LIMIT; i++)
+    {
+        if (cycle_reg[i].callback != NULL)
+            sl_sim_deadline(cycle_reg[i].tick_start + cycle_reg[i].delay_ms);
+    }
+
+    for (int i = 0; i < SL_MULTIPLE_LIMIT; i++)
+    {
+        if (multiple_reg[i].callback != NULL)
+            sl_sim_deadline(multiple_reg[i].tick_start + multiple_reg[i].delay_ms);
+    }
+}
+
+#endif
+
+/* ============================================================== */
+
 /* 并行任务注册表 */
 static pfunc task_reg[SL_PARALLEL_LIMIT];
 
+/* 正在运行的并行任务，sl_yield 据此跳过调用者 */
+static pfunc task_now;
+
+/* 并行任务轮询轮数 */
+static uint32_t round_num;
+
 /* 并行任务运行 */
-void parallel_task_run(void)
+sl_ramfunc void parallel_task_run(void)
 {
+    /* 虚拟时间仿真：上一轮无进展时推进 tick */
+    sl_sim_round();
+
+    sl_load_loop();
+
+    round_num++;
+
     for (int i = 0; i < SL_PARALLEL_LIMIT; i++)
     {
         if (task_reg[i] == NULL)
             continue;
 
-        task_reg[i]();
+        task_now = task_reg[i];
+
+        sl_task_call(task_reg[i], 1);
     }
+
+    task_now = NULL;
+}
+
+/* 阻塞等待中让出：运行一轮除调用者以外的并行任务。嵌套、中断中或关中断时不运行，返回 0 */
+char sl_yield(void)
+{
+    static char yielding;
+
+    pfunc self = task_now;
+
+    if (yielding || __get_IPSR() != 0 || __get_PRIMASK() != 0)
+        return 0;
+
+    yielding = 1;
+
+    /* 让出期间计为调用者的空闲 */
+    sl_load_idle_begin();
+
+    sl_sim_round();
+
+    sl_load_loop();
+
+    round_num++;
+
+    for (int i = 0; i < SL_PARALLEL_LIMIT; i++)
+    {
+        if (task_reg[i] == NULL || task_reg[i] == self)
+            continue;
+
+        task_now = task_reg[i];
+
+        sl_task_call(task_reg[i], 1);
+    }
+
+    task_now = self;
+
+    sl_load_idle_end();
+
+    yielding = 0;
+
+    return 1;
+}
+
+/* 获取并行任务轮询轮数，两次获取之间不变说明期间没有回到调度器 */
+uint32_t sl_get_round(void)
+{
+    return round_num;
 }
 
 /* 并行任务 */
@@ -554,6 +870,12 @@ void sl_task_start(pfunc task)
 {
     sl_check_task_not_null();
 
+#if SL_SHED_ENABLE
+    /* 降级期间的可选任务，恢复时再登记 */
+    if (sl_shed_hold(task))
+        return;
+#endif
+
     for (int i = 0; i < SL_PARALLEL_LIMIT; i++)
     {
         if (task_reg[i] == task)
@@ -568,6 +890,8 @@ void sl_task_start(pfunc task)
         {
             task_reg[i] = task;
 
+            sl_mem_peak(parallel, i);
+
             return;
         }
     }
@@ -579,6 +903,10 @@ void sl_task_stop(pfunc task)
 {
     sl_check_task_not_null();
 
+#if SL_SHED_ENABLE
+    sl_shed_drop(task);
+#endif
+
     for (int i = 0; i < SL_PARALLEL_LIMIT; i++)
     {
         if (task_reg[i] == task)
@@ -590,6 +918,22 @@ void sl_task_stop(pfunc task)
     }
 }
 
+#if SL_SHED_ENABLE
+
+/* 是否已登记为并行任务 */
+char sl_task_running(pfunc task)
+{
+    for (int i = 0; i < SL_PARALLEL_LIMIT; i++)
+    {
+        if (task_reg[i] == task)
+            return 1;
+    }
+
+    return 0;
+}
+
+#endif
+
 /* ============================================================== */
 
 /* 单次任务注册表 */
@@ -598,7 +942,7 @@ static pfunc once_task_reg[SL_ONCE_LIMIT];
 static int soft_timer_count;
 
 /* 单次任务运行 */
-void once_task_run(void)
+sl_ramfunc void once_task_run(void)
 {
     static pfunc backup_reg[SL_ONCE_LIMIT];
 
@@ -617,7 +961,9 @@ void once_task_run(void)
         /* 运行一次后，取消注册 */
         once_task_reg[i] = NULL;
 
-        backup_reg[i]();
+        sl_task_call(backup_reg[i], 0);
+
+        sl_sim_busy();
 
         if (backup_reg[i] == soft_timer)
             soft_timer_count = 0;
@@ -625,7 +971,7 @@ void once_task_run(void)
 }
 
 /* 单次任务 */
-void sl_task_once(pfunc task)
+sl_ramfunc void sl_task_once(pfunc task)
 {
     sl_check_task_not_null();
 
@@ -652,6 +998,8 @@ void sl_task_once(pfunc task)
         {
             once_task_reg[i] = task;
 
+            sl_mem_peak(once, i);
+
             return;
         }
     }
@@ -672,6 +1020,8 @@ void sl_goto(pfunc task)
 {
     sl_check_task_not_null();
 
+    sl_sim_busy();
+
     if (wait)
     {
         /* 切换任务，强制中断等待 */
@@ -700,11 +1050,11 @@ void sl_load_new_task(void)
 }
 
 /* 互斥任务运行 */
-void mutex_task_run(void)
+sl_ramfunc void mutex_task_run(void)
 {
     if (run_task != NULL)
     {
-        run_task();
+        sl_task_call(run_task, 1);
     }
 }
 
@@ -734,8 +1084,12 @@ char sl_wait(int ms)
     /* 传入1ms，实际延时至少1ms */
     ms == 1 ? ms++ : ms;
 
+    sl_load_idle_begin();
+
     while (1)
     {
+        sl_sim_deadline(tick_start + ms);
+
         /* 轮询除当前任务以外的并行任务 */
         parallel_task_run();
 
@@ -746,6 +1100,8 @@ char sl_wait(int ms)
 
             wait = 0;
 
+            sl_load_idle_end();
+
             return 1;
         }
 
@@ -756,6 +1112,8 @@ char sl_wait(int ms)
 
             wait = 0;
 
+            sl_load_idle_end();
+
             return 0;
         }
 
@@ -767,6 +1125,8 @@ char sl_wait(int ms)
 
     wait = 0;
 
+    sl_load_idle_end();
+
     return 0;
 }
 
@@ -788,6 +1148,8 @@ char sl_wait_bare(void)
 
     char r = 0;
 
+    sl_load_idle_begin();
+
     while (1)
     {
         /* 轮询除当前任务以外的并行任务 */
@@ -816,6 +1178,8 @@ char sl_wait_bare(void)
 
     wait = 0;
 
+    sl_load_idle_end();
+
     return r;
 }
 
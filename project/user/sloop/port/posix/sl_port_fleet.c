@@ -0,0 +1,593 @@
+/**
+ ******************************************************************************
+ * @file    sl_port_fleet
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   多节点仿真：同一进程中运行多个 sloop 实例，共用虚拟时钟，
+ *          节点之间以按波特率传输的模拟串口总线互连
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#include "sloop.h"
+
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/*
+ * 节点镜像：内核、RTT、移植层与节点程序的全部静态数据在链接时归入 sl_node_data / sl_node_bss 两个段
+ * （见 project/host/Makefile）。每个节点有一份镜像副本和一个协程栈，运行哪个节点就把它的副本换入，
+ * 内核与应用代码不做任何改动即可多实例运行，目标板上也没有经由实例指针访问的开销。本文件不属于镜像。
+ *
+ * 调度：节点每轮主循环开始时报告状态（sl_sim_round）。有进展的节点继续运行，
+ * 等待推进时间时才让出并挂起，直到全局时刻到达其目标或收到总线数据。全部节点挂起时，
+ * 全局时刻跳到最早的目标；总线上有数据在传输时逐 ms 推进。节点恢复时自行补齐落后的 tick。
+ */
+
+extern char __start_sl_node_data[], __stop_sl_node_data[];
+extern char __start_sl_node_bss[], __stop_sl_node_bss[];
+
+/* 节点程序入口 */
+void _main(void);
+
+/* 节点协程栈，须大于移植层参与栈峰值统计的部分 */
+#define FLEET_STACK (SL_PORT_HOST_STACK + 16 * 1024)
+
+/* 节点接收缓冲区字节数，2 的幂 */
+#define FLEET_RX_SIZE 1024
+
+/* 总线发送队列字节数与帧数，2 的幂 */
+#define FLEET_BUS_SIZE 4096
+#define FLEET_BUS_FRAMES 256
+
+/* 单帧最大字节数 */
+#define FLEET_FRAME_MAX 256
+
+typedef struct
+{
+    ucontext_t ctx;
+
+    /* 镜像副本 */
+    char *image;
+
+    char *stack;
+
+    int bus;
+
+    /* 让出时的状态：SL_SIM_RUN / SL_SIM_WAIT / SL_SIM_IDLE，及等待的目标时刻 */
+    char want;
+    uint32_t target;
+
+    /* 收到总线数据，需要运行 */
+    char wake;
+
+    /* 接收缓冲区 */
+    uint8_t rx[FLEET_RX_SIZE];
+    uint32_t rx_head;
+    uint32_t rx_tail;
+    uint32_t rx_drop;
+
+    /* 文本输出处于行首 */
+    char line_start;
+
+} fleet_node_typ;
+
+/* 待发送帧 */
+typedef struct
+{
+    uint16_t node;
+
+    uint16_t len;
+
+    /* 入队时刻 */
+    uint32_t tick;
+
+} fleet_frame_typ;
+
+typedef struct
+{
+    uint8_t buf[FLEET_BUS_SIZE];
+    uint32_t head;
+    uint32_t tail;
+
+    fleet_frame_typ frame[FLEET_BUS_FRAMES];
+    uint32_t frame_head;
+    uint32_t frame_tail;
+
+    /* 队首帧已发送字节数 */
+    uint32_t sent;
+
+    /* 可发送字节数 ×1000，每 ms 增加 baud / 10 */
+    uint32_t credit;
+
+    /* 统计：帧数、字节数、排队时间之和与最大值 ms、发送队列满丢弃的帧数 */
+    uint32_t frames;
+    uint32_t bytes;
+    uint64_t delay_sum;
+    uint32_t delay_max;
+    uint32_t tx_drop;
+
+} fleet_bus_typ;
+
+static fleet_node_typ *node;
+static fleet_bus_typ *bus;
+
+static int node_num = 30;
+static int bus_num;
+
+/* 每条总线的节点数，0 为全部节点在同一条总线上 */
+static int bus_group;
+
+static uint32_t baud = 115200;
+
+/* 仿真时长 ms、随机种子、唤醒抖动上限 ms */
+static uint32_t fleet_ms = 10000;
+static uint32_t fleet_seed = 1;
+static uint32_t fleet_jitter;
+
+/* 输出全部节点的文本，默认只输出节点 0 */
+static char verbose;
+
+/* 全局时刻 */
+static uint32_t now;
+
+/* 当前换入的节点，-1 为无 */
+static int cur = -1;
+
+static ucontext_t sched_ctx;
+
+static size_t data_size;
+static size_t bss_size;
+
+/* 统计：节点主循环轮数、节点切换次数、跳转次数 */
+static uint64_t rounds;
+static uint64_t switches;
+static uint32_t jumps;
+
+static int64_t start_ns;
+
+/* ============================================================== */
+
+static int64_t fleet_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* 换入节点镜像 */
+static void fleet_swap(int k)
+{
+    if (cur == k)
+        return;
+
+    if (cur >= 0)
+    {
+        memcpy(node[cur].image, __start_sl_node_data, data_size);
+
+        memcpy(node[cur].image + data_size, __start_sl_node_bss, bss_size);
+    }
+
+    memcpy(__start_sl_node_data, node[k].image, data_size);
+
+    memcpy(__start_sl_node_bss, node[k].image + data_size, bss_size);
+
+    cur = k;
+}
+
+/* 运行节点一轮 */
+static void fleet_resume(int k)
+{
+    fleet_swap(k);
+
+    node[k].wake = 0;
+
+    switches++;
+
+    swapcontext(&sched_ctx, &node[k].ctx);
+}
+
+/* 节点协程入口 */
+static void fleet_entry(void)
+{
+    sl_port_sim_node(fleet_seed + cur * 7919, fleet_jitter);
+
+    _main();
+}
+
+/* ============================================================== */
+
+int sl_fleet_node(void)
+{
+    return cur;
+}
+
+int sl_fleet_nodes(void)
+{
+    return node_num;
+}
+
+int sl_fleet_send(const void *buf, int len)
+{
+    fleet_bus_typ *b = &bus[node[cur].bus];
+
+    if (len <= 0 || len > FLEET_FRAME_MAX ||
+        b->frame_tail - b->frame_head >= FLEET_BUS_FRAMES ||
+        b->tail - b->head + len > FLEET_BUS_SIZE)
+    {
+        b->tx_drop++;
+
+        return 0;
+    }
+
+    for (int i = 0; i < len; i++)
+        b->buf[(b->tail + i) & (FLEET_BUS_SIZE - 1)] = ((const uint8_t *)buf)[i];
+
+    b->tail += len;
+
+    fleet_frame_typ *f = &b->frame[b->frame_tail & (FLEET_BUS_FRAMES - 1)];
+
+    f->node = cur;
+
+    f->len = len;
+
+    f->tick = now;
+
+    b->frame_tail++;
+
+    return len;
+}
+
+int sl_fleet_recv(void *buf, int len)
+{
+    fleet_node_typ *n = &node[cur];
+
+    int i = 0;
+
+    while (i < len && n->rx_head != n->rx_tail)
+        ((uint8_t *)buf)[i++] = n->rx[n->rx_head++ & (FLEET_RX_SIZE - 1)];
+
+    /* 收到数据即为进展 */
+    if (i > 0)
+        sl_sim_busy();
+
+    return i;
+}
+
+uint32_t sl_fleet_yield(char want, uint32_t target)
+{
+    rounds++;
+
+    /* 同一 ms 内节点之间只经总线交互，而总线在推进时间时才传输，有进展的节点可以连续运行 */
+    if (want == SL_SIM_RUN)
+        return now;
+
+    node[cur].want = want;
+
+    node[cur].target = target;
+
+    swapcontext(&node[cur].ctx, &sched_ctx);
+
+    return now;
+}
+
+void sl_fleet_text(const char *p, unsigned n)
+{
+    if (verbose == 0 && cur != 0)
+        return;
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        /* 空行不加前缀 */
+        if (node[cur].line_start && p[i] != '\r' && p[i] != '\n')
+            printf("n%03d ", cur);
+
+        putchar(p[i]);
+
+        node[cur].line_start = (p[i] == '\n');
+    }
+
+    fflush(stdout);
+}
+
+/* ============================================================== */
+
+/* 总线传输 1ms：按波特率把队首帧逐字节广播给同一总线上的其他节点，帧结束时唤醒接收方 */
+static void bus_step(int k)
+{
+    fleet_bus_typ *b = &bus[k];
+
+    if (b->frame_head == b->frame_tail)
+        return;
+
+    /* 每字节 10 位 */
+    b->credit += baud / 10;
+
+    while (b->credit >= 1000 && b->frame_head != b->frame_tail)
+    {
+        fleet_frame_typ *f = &b->frame[b->frame_head & (FLEET_BUS_FRAMES - 1)];
+
+        /* 帧开始发送，记录排队时间 */
+        if (b->sent == 0)
+        {
+            uint32_t delay = now - f->tick;
+
+            b->delay_sum += delay;
+
+            if (delay > b->delay_max)
+                b->delay_max = delay;
+        }
+
+        uint8_t byte = b->buf[b->head++ & (FLEET_BUS_SIZE - 1)];
+
+        /* 同一总线上的节点序号连续 */
+        for (int i = k * bus_group; i < node_num && i < (k + 1) * bus_group; i++)
+        {
+            fleet_node_typ *n = &node[i];
+
+            if (i == f->node)
+                continue;
+
+            if (n->rx_tail - n->rx_head >= FLEET_RX_SIZE)
+            {
+                n->rx_drop++;
+
+                continue;
+            }
+
+            n->rx[n->rx_tail++ & (FLEET_RX_SIZE - 1)] = byte;
+        }
+
+        b->credit -= 1000;
+
+        b->bytes++;
+
+        if (++b->sent == f->len)
+        {
+            b->sent = 0;
+
+            b->frames++;
+
+            b->frame_head++;
+
+            /* 帧结束时唤醒接收方，相当于串口空闲中断 */
+            for (int i = k * bus_group; i < node_num && i < (k + 1) * bus_group; i++)
+            {
+                if (i != f->node)
+                    node[i].wake = 1;
+            }
+        }
+    }
+
+    /* 总线空闲时不积累发送额度 */
+    if (b->frame_head == b->frame_tail)
+        b->credit = 0;
+}
+
+/* 节点本轮是否需要运行 */
+static char fleet_runnable(fleet_node_typ *n)
+{
+    return n->want == SL_SIM_RUN || n->wake || (n->want == SL_SIM_WAIT && (int32_t)(n->target - now) <= 0);
+}
+
+/* 仿真结束，输出剩余文本与统计后退出 */
+static void fleet_finish(const char *why)
+{
+    double wall_ms = (fleet_now_ns() - start_ns) / 1e6;
+
+    for (int k = 0; k < node_num; k++)
+    {
+        fleet_swap(k);
+
+        sl_port_host_flush();
+    }
+
+    printf("\nfleet %s: %d nodes on %d bus, %u ms simulated in %.3f ms wall, %llu rounds, %llu switches, %u jumps, seed %u\n",
+           why, node_num, bus_num, (unsigned)now, wall_ms, (unsigned long long)rounds, (unsigned long long)switches,
+           (unsigned)jumps, (unsigned)fleet_seed);
+
+    if (now)
+        printf("fleet: %.1f us wall per simulated second, %.2f us per node-second\n",
+               wall_ms * 1e6 / now, wall_ms * 1e6 / now / node_num);
+
+    for (int k = 0; k < bus_num; k++)
+    {
+        fleet_bus_typ *b = &bus[k];
+
+        uint32_t rx_drop = 0;
+
+        for (int i = 0; i < node_num; i++)
+        {
+            if (node[i].bus == k)
+                rx_drop += node[i].rx_drop;
+        }
+
+        printf("bus %d: %u frames, %u bytes, %.1f%% busy, queue delay avg %.2f ms max %u ms, tx drop %u, rx drop %u\n",
+               k, (unsigned)b->frames, (unsigned)b->bytes, now ? b->bytes * 10 * 100.0 * 1000 / baud / now : 0.0,
+               b->frames ? (double)b->delay_sum / b->frames : 0.0, (unsigned)b->delay_max,
+               (unsigned)b->tx_drop, (unsigned)rx_drop);
+    }
+
+    exit(0);
+}
+
+/* 调度：运行全部可运行节点，全部挂起时推进全局时刻 */
+static void fleet_run(void)
+{
+    while (1)
+    {
+        char idle = 1;
+
+        for (int k = 0; k < node_num; k++)
+        {
+            if (fleet_runnable(&node[k]))
+            {
+                fleet_resume(k);
+
+                idle = 0;
+            }
+        }
+
+        if (idle == 0)
+            continue;
+
+        /* 全部节点挂起，找最早的目标时刻 */
+        char has_next = 0;
+
+        uint32_t next = 0;
+
+        for (int k = 0; k < node_num; k++)
+        {
+            if (node[k].want != SL_SIM_WAIT)
+                continue;
+
+            if (has_next == 0 || (int32_t)(node[k].target - next) < 0)
+                next = node[k].target;
+
+            has_next = 1;
+        }
+
+        /* 总线传输中，逐 ms 推进 */
+        for (int k = 0; k < bus_num; k++)
+        {
+            if (bus[k].frame_head != bus[k].frame_tail)
+            {
+                next = now + 1;
+
+                has_next = 1;
+            }
+        }
+
+        if (has_next == 0)
+            fleet_finish("idle");
+
+        if ((int32_t)(next - fleet_ms) > 0)
+            next = fleet_ms;
+
+        jumps++;
+
+        while (now != next)
+        {
+            now++;
+
+            for (int k = 0; k < bus_num; k++)
+                bus_step(k);
+        }
+
+        if (now >= fleet_ms)
+            fleet_finish("done");
+    }
+}
+
+/* 解析命令行并运行全部节点，不返回
+ * -n 节点数，-g 每条总线的节点数，-b 波特率，-t 仿真时长 ms，-s 随机种子，-j 唤醒抖动上限 ms，-v 输出全部节点文本 */
+void sl_port_host_start(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:g:b:t:s:j:v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            node_num = atoi(optarg);
+            break;
+
+        case 'g':
+            bus_group = atoi(optarg);
+            break;
+
+        case 'b':
+            baud = strtoul(optarg, NULL, 0);
+            break;
+
+        case 't':
+            fleet_ms = strtoul(optarg, NULL, 0);
+            break;
+
+        case 's':
+            fleet_seed = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'j':
+            fleet_jitter = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'v':
+            verbose = 1;
+            break;
+
+        default:
+            fprintf(stderr, "usage: %s [-n nodes] [-g nodes_per_bus] [-b baud] [-t ms] [-s seed] [-j jitter_ms] [-v]\n", argv[0]);
+            exit(2);
+        }
+    }
+
+    if (node_num < 1)
+        node_num = 1;
+
+    if (bus_group < 1 || bus_group > node_num)
+        bus_group = node_num;
+
+    bus_num = (node_num + bus_group - 1) / bus_group;
+
+    data_size = __stop_sl_node_data - __start_sl_node_data;
+
+    bss_size = __stop_sl_node_bss - __start_sl_node_bss;
+
+    node = calloc(node_num, sizeof *node);
+
+    bus = calloc(bus_num, sizeof *bus);
+
+    if (node == NULL || bus == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    /* 此时镜像尚未运行过，即为各节点的初始镜像 */
+    for (int k = 0; k < node_num; k++)
+    {
+        fleet_node_typ *n = &node[k];
+
+        n->image = malloc(data_size + bss_size);
+
+        n->stack = malloc(FLEET_STACK);
+
+        if (n->image == NULL || n->stack == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+
+        memcpy(n->image, __start_sl_node_data, data_size);
+
+        memcpy(n->image + data_size, __start_sl_node_bss, bss_size);
+
+        n->bus = k / bus_group;
+
+        n->want = SL_SIM_RUN;
+
+        n->line_start = 1;
+
+        getcontext(&n->ctx);
+
+        n->ctx.uc_stack.ss_sp = n->stack;
+
+        n->ctx.uc_stack.ss_size = FLEET_STACK;
+
+        n->ctx.uc_link = NULL;
+
+        makecontext(&n->ctx, fleet_entry, 0);
+    }
+
+    start_ns = fleet_now_ns();
+
+    fleet_run();
+}
+
+/************************** END OF FILE **************************/
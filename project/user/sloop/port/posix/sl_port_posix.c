@@ -0,0 +1,733 @@
+/**
+ ******************************************************************************
+ * @file    sl_port_posix
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   POSIX 移植层实现：SIGALRM 每 ms 触发一次 sl_tick_irq，
+ *          RTT 通道0输出到 stdout，其余通道写入 sl_rtt<n>.bin
+ *          定义 SL_PORT_SIM 时改为虚拟时间：主循环无进展时 tick 直接跳到最近的到期时刻
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#include "sloop.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * tick 信号在主线程中执行，与目标板上 SysTick 打断主循环一致。
+ * 关中断只置标志位，不调用系统函数：关中断期间到达的 tick 记为挂起，在开中断时补执行，
+ * 与 NVIC 挂起位一样多次到达只记一次。RTT 输出线程屏蔽 tick 信号，只读取上行缓冲区，相当于调试器。
+ */
+
+/*
+ * 虚拟时间仿真没有 tick 信号与输出线程，全部在主线程中进行。每轮主循环开始时检查上一轮：
+ * 有任务切换、Flow 恢复、单次任务运行或事件/通道发送即为有进展，tick 不动，继续下一轮；
+ * 连续 SIM_SETTLE 轮无进展，则 tick 跳到各等待登记的最早到期时刻，逐 ms 执行 sl_tick_irq。
+ * 未经内核接口、自行比较 sl_get_tick 的等待须用 sl_sim_deadline 登记，否则会被跳过而迟到。
+ */
+
+/* 编译器屏障 */
+#define port_barrier() __asm__ volatile("" ::: "memory")
+
+volatile int sl_port_in_isr;
+
+/* 模拟 PRIMASK 与 SysTick 挂起位 */
+static volatile sig_atomic_t irq_masked;
+static volatile sig_atomic_t irq_pending;
+
+/* 最近一次 tick 中断的时刻 ns */
+static volatile int64_t tick_ns;
+
+static SysTick_Type systick = {0, SL_PORT_HOST_HZ / 1000 - 1, 0, 0};
+
+/* RTT 输出线程与退出时的输出互斥 */
+static pthread_mutex_t rtt_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static FILE *rtt_file[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+
+static uint32_t *stack_top;
+
+/* ============================================================== */
+
+/* 单调时钟 ns */
+static int64_t port_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t sl_port_irq_masked(void)
+{
+    return irq_masked;
+}
+
+/* 执行 tick 中断 */
+static void port_tick_isr(void)
+{
+    sl_port_in_isr = 1;
+
+    port_barrier();
+
+    tick_ns = port_now_ns();
+
+    sl_tick_irq();
+
+    port_barrier();
+
+    sl_port_in_isr = 0;
+}
+
+#if !defined(SL_PORT_SIM)
+
+/* tick 信号，关中断或中断中到达时挂起 */
+static void port_tick_signal(int sig)
+{
+    (void)sig;
+
+    if (irq_masked || sl_port_in_isr)
+    {
+        irq_pending = 1;
+
+        return;
+    }
+
+    port_tick_isr();
+}
+
+/* ============================================================== */
+
+void sl_port_irq_disable(void)
+{
+    irq_masked = 1;
+
+    port_barrier();
+}
+
+void sl_port_irq_enable(void)
+{
+    port_barrier();
+
+    /* 中断中开中断，挂起的 tick 留到中断返回后处理 */
+    if (sl_port_in_isr)
+    {
+        irq_masked = 0;
+
+        return;
+    }
+
+    while (1)
+    {
+        /* 补执行挂起的 tick，期间保持关中断 */
+        while (irq_pending)
+        {
+            irq_masked = 1;
+
+            irq_pending = 0;
+
+            port_tick_isr();
+        }
+
+        irq_masked = 0;
+
+        port_barrier();
+
+        /* 清除屏蔽前又有 tick 挂起，再补执行一次 */
+        if (irq_pending == 0)
+            return;
+    }
+}
+
+unsigned sl_port_irq_save(void)
+{
+    unsigned state = irq_masked;
+
+    sl_port_irq_disable();
+
+    return state;
+}
+
+void sl_port_irq_restore(unsigned state)
+{
+    if (state == 0)
+        sl_port_irq_enable();
+}
+
+/* SysTick 递减计数，按距上次 tick 的时间换算 */
+SysTick_Type *sl_port_systick(void)
+{
+    int64_t count = (port_now_ns() - tick_ns) * (SL_PORT_HOST_HZ / 1000000) / 1000;
+
+    /* tick 信号迟到时停在 0，与硬件计数回绕前一致 */
+    if (count > systick.LOAD)
+        count = systick.LOAD;
+
+    systick.VAL = systick.LOAD - (uint32_t)count;
+
+    return &systick;
+}
+
+/* 周期计数直接取单调时钟，不受 tick 信号迟到影响 */
+uint32_t sl_get_cycle(void)
+{
+    return (uint32_t)(port_now_ns() * (SL_PORT_HOST_HZ / 1000000) / 1000);
+}
+
+#endif
+
+/* ============================================================== */
+
+/* 输出一段 RTT 数据，通道0输出到 stdout，其余通道写入文件 */
+static void port_rtt_out(int ch, const char *p, unsigned n)
+{
+#if defined(SL_PORT_FLEET)
+    /* 多节点仿真：文本由调度器加节点前缀输出，其余通道只保留节点 0 */
+    if (ch == 0)
+    {
+        sl_fleet_text(p, n);
+
+        return;
+    }
+
+    if (sl_fleet_node() != 0)
+        return;
+#endif
+
+    FILE *out = stdout;
+
+    if (ch > 0)
+    {
+        if (rtt_file[ch] == NULL)
+        {
+            char name[16];
+
+            snprintf(name, sizeof name, "sl_rtt%d.bin", ch);
+
+            rtt_file[ch] = fopen(name, "wb");
+        }
+
+        out = rtt_file[ch];
+    }
+
+    if (out == NULL)
+        return;
+
+    fwrite(p, 1, n, out);
+
+    fflush(out);
+}
+
+/* 读出 RTT 上行缓冲区 */
+static void port_rtt_drain(void)
+{
+    pthread_mutex_lock(&rtt_mutex);
+
+    for (int i = 0; i < SEGGER_RTT_MAX_NUM_UP_BUFFERS; i++)
+    {
+        SEGGER_RTT_BUFFER_UP *up = (SEGGER_RTT_BUFFER_UP *)&_SEGGER_RTT.aUp[i];
+
+        if (up->pBuffer == NULL)
+            continue;
+
+#if SL_LOG_BACKEND == SL_BACKEND_UART
+        /* 通道0由 UART 后端在主循环中取走，经 sl_log_uart_sink 输出 */
+        if (i == SL_RTT_CH_TEXT)
+            continue;
+#endif
+
+        unsigned wr = up->WrOff;
+
+        unsigned rd = up->RdOff;
+
+        if (rd == wr)
+            continue;
+
+        /* 先读写偏移再读数据 */
+        __sync_synchronize();
+
+        /* 跨越缓冲区末尾时分两段输出 */
+        if (wr < rd)
+        {
+            port_rtt_out(i, up->pBuffer + rd, up->SizeOfBuffer - rd);
+
+            rd = 0;
+        }
+
+        port_rtt_out(i, up->pBuffer + rd, wr - rd);
+
+        __sync_synchronize();
+
+        up->RdOff = wr;
+    }
+
+    pthread_mutex_unlock(&rtt_mutex);
+}
+
+#if SL_LOG_BACKEND == SL_BACKEND_UART
+
+/* UART 后端测试桩的发送内容输出到 stdout，与 RTT 通道0一致 */
+void sl_log_uart_sink(const uint8_t *buf, int len)
+{
+    pthread_mutex_lock(&rtt_mutex);
+
+    port_rtt_out(SL_RTT_CH_TEXT, (const char *)buf, len);
+
+    pthread_mutex_unlock(&rtt_mutex);
+}
+
+#endif
+
+#if !defined(SL_PORT_SIM)
+
+/* RTT 输出线程，相当于调试器每 ms 读取一次 */
+static void *port_rtt_thread(void *arg)
+{
+    (void)arg;
+
+    while (1)
+    {
+        port_rtt_drain();
+
+        usleep(1000);
+    }
+
+    return NULL;
+}
+
+#endif
+
+/* 栈区间：启动时所在位置以下 SL_PORT_HOST_STACK 字节 */
+void sl_stack_region(uint32_t **bottom, uint32_t **top)
+{
+    *top = stack_top;
+
+    *bottom = stack_top - SL_PORT_HOST_STACK / 4;
+}
+
+/* 输出 RTT 上行缓冲区中剩余的数据 */
+void sl_port_host_flush(void)
+{
+    port_rtt_drain();
+}
+
+#if !defined(SL_PORT_SIM)
+
+/* 启动 1ms tick 信号与 RTT 输出线程，命令行参数仅仿真时使用 */
+void sl_port_host_start(int argc, char **argv)
+{
+    pthread_t thread;
+
+    sigset_t set;
+
+    (void)argc;
+
+    (void)argv;
+
+    volatile uint32_t mark;
+
+    stack_top = (uint32_t *)((uintptr_t)&mark & ~(uintptr_t)7);
+
+    tick_ns = port_now_ns();
+
+    /* 输出线程不接收 tick 信号 */
+    sigemptyset(&set);
+
+    sigaddset(&set, SIGALRM);
+
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    pthread_create(&thread, NULL, port_rtt_thread, NULL);
+
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+
+    atexit(sl_port_host_flush);
+
+    struct sigaction sa = {0};
+
+    sa.sa_handler = port_tick_signal;
+
+    sa.sa_flags = SA_RESTART;
+
+    sigaction(SIGALRM, &sa, NULL);
+
+    struct itimerval timer = {{0, 1000}, {0, 1000}};
+
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+#else
+
+/* ============================================================== */
+/* 虚拟时间仿真 */
+
+/* 连续无进展多少轮后推进 tick，留给未经内核接口的用户状态机走完一步 */
+#define SIM_SETTLE 2
+
+/* 同一 tick 下连续有进展的轮数上限，超过视为忙碌，推进 1ms，避免虚拟时间停滞 */
+#define SIM_BUSY_LIMIT 100000
+
+/* 随机种子、唤醒抖动上限 ms */
+static uint32_t sim_seed = 1;
+static uint32_t sim_jitter;
+
+/* 命令行给定的种子，随机数状态会改写 sim_seed */
+static uint32_t sim_seed_init = 1;
+
+/* 上一轮有进展 */
+static char sim_active;
+
+/* 连续无进展轮数 / 同一 tick 下连续有进展轮数 */
+static int sim_quiet;
+static int sim_busy_rounds;
+
+/* 上次推进以来登记的最早到期时刻 */
+static char sim_has_due;
+static uint32_t sim_due;
+
+/* 本次要推进到的 tick，已计入抖动 */
+static char sim_want;
+static uint32_t sim_target;
+
+static uint32_t sim_signal;
+
+/* 统计：主循环轮数、跳转次数 */
+static uint32_t sim_rounds;
+static uint32_t sim_jumps;
+
+static int64_t sim_start_ns;
+
+/* 跳过的周期数，计入周期计数 */
+static uint32_t sim_skip;
+
+/* 本 ms 内 sl_sim_work 模拟的计算周期数 */
+static uint32_t sim_work;
+
+/* 让出给其他节点的时间 ns，不计入周期计数 */
+static int64_t sim_away;
+
+void sl_port_irq_disable(void)
+{
+    irq_masked = 1;
+}
+
+void sl_port_irq_enable(void)
+{
+    irq_masked = 0;
+}
+
+unsigned sl_port_irq_save(void)
+{
+    unsigned state = irq_masked;
+
+    irq_masked = 1;
+
+    return state;
+}
+
+void sl_port_irq_restore(unsigned state)
+{
+    irq_masked = state;
+}
+
+/* SysTick 计数按距上次 tick 的真实耗时换算，每 ms 计数随模拟的时钟变化 */
+SysTick_Type *sl_port_systick(void)
+{
+    int64_t count = (port_now_ns() - tick_ns) * (systick.LOAD + 1) / 1000000;
+
+    if (count > systick.LOAD)
+        count = systick.LOAD;
+
+    systick.VAL = systick.LOAD - (uint32_t)count;
+
+    return &systick;
+}
+
+/* 周期计数为真实耗时加上跳过的时间，负载与延迟统计反映任务的实际执行时间。
+ * 真实耗时按全速换算：同样的计算在降频后占用同样的周期数，即更长的时间 */
+uint32_t sl_get_cycle(void)
+{
+    return (uint32_t)((port_now_ns() - sim_start_ns - sim_away) * (SL_PORT_HOST_HZ / 1000000) / 1000) + sim_skip;
+}
+
+uint32_t sl_sim_rand(void)
+{
+    /* xorshift32 */
+    sim_seed ^= sim_seed << 13;
+
+    sim_seed ^= sim_seed >> 17;
+
+    sim_seed ^= sim_seed << 5;
+
+    return sim_seed;
+}
+
+void sl_sim_deadline(uint32_t due)
+{
+    if (sim_has_due == 0 || (int32_t)(due - sim_due) < 0)
+        sim_due = due;
+
+    sim_has_due = 1;
+}
+
+void sl_sim_busy(void)
+{
+    sim_active = 1;
+}
+
+#if !defined(SL_PORT_FLEET)
+
+/* 仿真时长 ms */
+static uint32_t sim_ms = 10000;
+
+/* 仿真结束，输出统计后退出 */
+static void sim_finish(const char *why)
+{
+    double wall_ms = (port_now_ns() - sim_start_ns) / 1e6;
+
+    port_rtt_drain();
+
+    printf("\nsim %s: %u ms simulated in %.3f ms wall, %u rounds, %u jumps, %.1f us wall per simulated second, seed %u\n",
+           why, (unsigned)sl_get_tick(), wall_ms, (unsigned)sim_rounds, (unsigned)sim_jumps,
+           sl_get_tick() ? wall_ms * 1e6 / sl_get_tick() : 0.0, (unsigned)sim_seed_init);
+
+    exit(0);
+}
+
+#endif
+
+/* 推进 ms 个 tick，本 ms 内已模拟的计算不计为空闲 */
+static void sim_advance(uint32_t ms)
+{
+    uint32_t cycles = ms * (systick.LOAD + 1) - sim_work;
+
+    sim_work = 0;
+
+    sim_jumps++;
+
+    /* 先推进周期计数，跳过的时间计为空闲 */
+    sim_skip += cycles;
+
+    sl_load_skip(cycles);
+
+    while (ms--)
+    {
+#if !defined(SL_PORT_FLEET)
+        if (sl_get_tick() >= sim_ms)
+            sim_finish("done");
+#endif
+
+        port_tick_isr();
+    }
+
+    sim_has_due = 0;
+
+    sim_want = SL_SIM_RUN;
+
+    sim_quiet = 0;
+
+    sim_busy_rounds = 0;
+}
+
+#if !defined(SL_PORT_FLEET)
+
+void sl_sim_work(uint32_t cycles)
+{
+    /* 计入周期计数，不计为空闲 */
+    sim_skip += cycles;
+
+    sim_work += cycles;
+
+    /* 跨越 ms 边界时执行 tick */
+    while (sim_work >= systick.LOAD + 1)
+    {
+        sim_work -= systick.LOAD + 1;
+
+        if (sl_get_tick() >= sim_ms)
+            sim_finish("done");
+
+        port_tick_isr();
+    }
+}
+
+#endif
+
+/* 调频：模拟 HCLK 为 SL_PORT_HOST_HZ / div，本 ms 内已走过的比例不变 */
+char sl_gov_clock(uint32_t div)
+{
+    uint32_t full = SL_PORT_HOST_HZ / div / 1000;
+
+    sim_work = (uint64_t)sim_work * full / (systick.LOAD + 1);
+
+    systick.LOAD = full - 1;
+
+    return 1;
+}
+
+/* 确定要推进到的 tick，无到期时刻返回 SL_SIM_IDLE */
+static char sim_plan(void)
+{
+    sl_timer_deadline();
+
+    /* 没有任何等待中的到期时刻，此后不会再有进展 */
+    if (sim_has_due == 0)
+        return SL_SIM_IDLE;
+
+    int32_t step = (int32_t)(sim_due - sl_get_tick());
+
+    /* 已过期的登记（等待已被取消）只推进 1ms */
+    if (step < 1)
+        step = 1;
+
+    /* 随机推迟唤醒，模拟其他工作占用 CPU */
+    if (sim_jitter)
+        step += sl_sim_rand() % (sim_jitter + 1);
+
+    sim_target = sl_get_tick() + step;
+
+    return SL_SIM_WAIT;
+}
+
+/* 报告本轮状态，返回当前时刻：单节点时直接推进，多节点时让出给调度器 */
+static uint32_t sim_wait(char want, uint32_t target)
+{
+#if defined(SL_PORT_FLEET)
+    int64_t t = port_now_ns();
+
+    uint32_t now = sl_fleet_yield(want, target);
+
+    sim_away += port_now_ns() - t;
+
+    return now;
+#else
+    if (want == SL_SIM_IDLE)
+        sim_finish("idle");
+
+    return want == SL_SIM_WAIT ? target : sl_get_tick();
+#endif
+}
+
+void sl_sim_round(void)
+{
+    sim_rounds++;
+
+    port_rtt_drain();
+
+    /* 事件或通道发送也算进展 */
+    if (sim_signal != flow_signal)
+    {
+        sim_signal = flow_signal;
+
+        sim_active = 1;
+    }
+
+    char want = SL_SIM_RUN;
+
+    uint32_t target = 0;
+
+    if (sim_active)
+    {
+        sim_active = 0;
+
+        sim_quiet = 0;
+
+        if (++sim_busy_rounds >= SIM_BUSY_LIMIT)
+        {
+            want = SL_SIM_WAIT;
+
+            target = sl_get_tick() + 1;
+        }
+    }
+    else if (++sim_quiet >= SIM_SETTLE)
+    {
+        /* 到期时刻与抖动每次推进只确定一次 */
+        if (sim_want == SL_SIM_RUN)
+            sim_want = sim_plan();
+
+        want = sim_want;
+
+        target = sim_target;
+    }
+
+    uint32_t now = sim_wait(want, target);
+
+    if (now != sl_get_tick())
+        sim_advance(now - sl_get_tick());
+}
+
+/* 初始化仿真状态，须在节点自己的栈上调用 */
+static void sim_init(uint32_t seed, uint32_t jitter)
+{
+    volatile uint32_t mark;
+
+    /* xorshift 种子不能为 0 */
+    sim_seed = seed ? seed : 1;
+
+    sim_seed_init = sim_seed;
+
+    sim_jitter = jitter;
+
+    stack_top = (uint32_t *)((uintptr_t)&mark & ~(uintptr_t)7);
+
+    sim_start_ns = port_now_ns();
+
+    tick_ns = sim_start_ns;
+}
+
+#if defined(SL_PORT_FLEET)
+
+/* 多节点仿真：节点协程开始时调用，之后进入 _main */
+void sl_port_sim_node(uint32_t seed, uint32_t jitter)
+{
+    sim_init(seed, jitter);
+}
+
+#else
+
+/* 解析命令行：-t 仿真时长 ms，-s 随机种子，-j 唤醒抖动上限 ms */
+void sl_port_host_start(int argc, char **argv)
+{
+    uint32_t seed = 1;
+
+    uint32_t jitter = 0;
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:s:j:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            sim_ms = strtoul(optarg, NULL, 0);
+            break;
+
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'j':
+            jitter = strtoul(optarg, NULL, 0);
+            break;
+
+        default:
+            fprintf(stderr, "usage: %s [-t ms] [-s seed] [-j jitter_ms]\n", argv[0]);
+            exit(2);
+        }
+    }
+
+    sim_init(seed, jitter);
+
+    atexit(sl_port_host_flush);
+}
+
+#endif
+
+#endif
+
+/************************** END OF FILE **************************/
@@ -0,0 +1,160 @@
+/**
+ ******************************************************************************
+ * @file    sl_port_posix
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   POSIX 移植层：以 SIGALRM 模拟 SysTick 中断，以标志位模拟 PRIMASK，
+ *          SysTick 计数由单调时钟换算，RTT 上行缓冲区由后台线程输出
+ *          定义 SL_PORT_SIM 时为虚拟时间仿真，tick 由主循环在空闲时推进
+ *          再定义 SL_PORT_FLEET 时为多节点仿真，多个实例共用虚拟时钟，经模拟总线互连
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#ifndef __sl_port_posix_H
+#define __sl_port_posix_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/* 模拟的内核时钟，决定 SysTick 每 ms 计数值与周期计数的单位 */
+#ifndef SL_PORT_HOST_HZ
+#define SL_PORT_HOST_HZ 64000000
+#endif
+
+/* 主线程栈中参与栈峰值统计的部分 */
+#ifndef SL_PORT_HOST_STACK
+#define SL_PORT_HOST_STACK (64 * 1024)
+#endif
+
+/* ============================================================== */
+/* 中断 */
+
+/* 关/开中断：关中断期间到达的 tick 挂起，开中断时补执行 */
+void sl_port_irq_disable(void);
+void sl_port_irq_enable(void);
+
+/* 保存并关中断 / 恢复，供 RTT 加锁使用 */
+unsigned sl_port_irq_save(void);
+void sl_port_irq_restore(unsigned state);
+
+/* 当前是否关中断 */
+uint32_t sl_port_irq_masked(void);
+
+/* 当前是否在 tick 中断中 */
+extern volatile int sl_port_in_isr;
+
+#define __disable_irq() sl_port_irq_disable()
+#define __enable_irq() sl_port_irq_enable()
+#define __get_PRIMASK() sl_port_irq_masked()
+
+#define __DMB() __sync_synchronize()
+
+/* 只模拟 SysTick 一个中断，优先级为最低 */
+typedef int IRQn_Type;
+
+#define SysTick_IRQn ((IRQn_Type)-1)
+
+#define __NVIC_PRIO_BITS 2
+
+static inline uint32_t __get_IPSR(void)
+{
+    /* SysTick 异常号为 15 */
+    return sl_port_in_isr ? 15 : 0;
+}
+
+static inline uint32_t NVIC_GetPriority(IRQn_Type irq)
+{
+    return (1u << __NVIC_PRIO_BITS) - 1;
+}
+
+/* ============================================================== */
+/* SysTick */
+
+typedef struct
+{
+    uint32_t CTRL;
+    uint32_t LOAD;
+    uint32_t VAL;
+    uint32_t CALIB;
+
+} SysTick_Type;
+
+/* 每次访问时按单调时钟刷新 VAL */
+SysTick_Type *sl_port_systick(void);
+
+#define SysTick (sl_port_systick())
+
+/* ============================================================== */
+/* 主机运行 */
+
+/* 启动 1ms tick 信号与 RTT 输出线程，在 _main 之前调用
+ * 仿真时解析命令行：-t 仿真时长 ms，-s 随机种子，-j 唤醒抖动上限 ms */
+void sl_port_host_start(int argc, char **argv);
+
+/* 输出 RTT 上行缓冲区中剩余的数据，进程退出时自动调用 */
+void sl_port_host_flush(void);
+
+/* ============================================================== */
+/* 虚拟时间仿真 */
+
+#if defined(SL_PORT_SIM)
+
+void sl_sim_round(void);
+void sl_sim_deadline(uint32_t due);
+void sl_sim_busy(void);
+
+/* 每轮结束时节点的状态：有进展继续运行 / 等待推进到目标 tick / 无到期时刻 */
+enum
+{
+    SL_SIM_RUN,
+    SL_SIM_WAIT,
+    SL_SIM_IDLE,
+};
+
+/* 伪随机数，由 -s 种子决定，供随机化时序场景使用 */
+uint32_t sl_sim_rand(void);
+
+/* 登记全部软件定时器的到期时刻，由内核提供 */
+void sl_timer_deadline(void);
+
+#if !defined(SL_PORT_FLEET)
+/* 模拟一段耗时 cycles 个周期的计算：计入负载，跨越 ms 边界时执行 tick。
+ * 周期数与时钟无关，SL_GOV_ENABLE 降频后同样的计算占用更长的时间 */
+void sl_sim_work(uint32_t cycles);
+#endif
+
+#endif
+
+/* ============================================================== */
+/* 多节点仿真，见 sl_port_fleet.c */
+
+#if defined(SL_PORT_FLEET)
+
+/* 当前节点序号（从0开始）与节点总数 */
+int sl_fleet_node(void);
+int sl_fleet_nodes(void);
+
+/* 向本节点所在总线发送一帧，总线按波特率逐字节广播给其他节点，队列满返回 0 */
+int sl_fleet_send(const void *buf, int len);
+
+/* 读取总线上收到的字节，返回读取数量 */
+int sl_fleet_recv(void *buf, int len);
+
+/* 以下供移植层使用 */
+
+/* 报告本轮状态并让出，返回全局时刻 */
+uint32_t sl_fleet_yield(char want, uint32_t target);
+
+/* 输出节点文本 */
+void sl_fleet_text(const char *p, unsigned n);
+
+/* 节点开始运行时初始化仿真状态 */
+void sl_port_sim_node(uint32_t seed, uint32_t jitter);
+
+#endif
+
+#endif /* __sl_port_posix_H */
+
+/************************** END OF FILE **************************/
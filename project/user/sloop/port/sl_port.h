@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * @file    sl_port
+ * @author  sloop
+ * @date    2026-10-19
+ * @brief   移植层：隔离内核对中断、tick、周期计数与 RTT 的硬件依赖
+ *
+ * ==此文件用户不应变更==
+ *****************************************************************************/
+
+#ifndef __sl_port_H
+#define __sl_port_H
+
+/*
+ * 内核只通过以下 CMSIS 接口访问硬件，移植到其他平台时提供同名实现即可：
+ * __disable_irq / __enable_irq   关/开中断（不嵌套，与 PRIMASK 语义一致）
+ * __get_PRIMASK                   当前是否关中断
+ * __DMB                           内存屏障
+ * __get_IPSR / NVIC_GetPriority   当前中断号与优先级，__NVIC_PRIO_BITS 为优先级位数
+ * SysTick->LOAD / SysTick->VAL    每 ms 计数值与当前计数（递减），用于周期计数时间戳
+ *
+ * 此外平台需每 ms 调用一次 sl_tick_irq，并由调试器或平台自身读出 RTT 上行缓冲区。
+ * 定义 SL_PORT_HOST 时使用 POSIX 实现（port/posix），可在 Linux 上运行内核与 Flow 演示；
+ * 同时定义 SL_PORT_SIM 时为虚拟时间仿真，没有 tick 中断，全部任务空闲时 tick 直接跳到下一个到期时刻。
+ */
+
+#if defined(SL_PORT_HOST)
+#include "sl_port_posix.h"
+#else
+#include "stm32g0xx_hal.h"
+#endif
+
+/* ============================================================== */
+/* 虚拟时间仿真钩子，仿真移植层之外为空 */
+
+#if !defined(SL_PORT_SIM)
+
+/* 主循环每轮开始时调用，本轮之前无进展时推进 tick */
+#define sl_sim_round()
+
+/* 登记一个等待中的到期时刻（tick 值），可用于表达式中 */
+#define sl_sim_deadline(due) ((void)0)
+
+/* 标记本轮有进展（任务切换、Flow 恢复等），暂不推进 tick */
+#define sl_sim_busy()
+
+#endif
+
+#endif /* __sl_port_H */
+
+/************************** END OF FILE **************************/
@@ -10,7 +10,7 @@
 #ifndef __sl_common_H
 #define __sl_common_H
 
-#include "stm32g0xx_hal.h"
+#include "sl_port.h"
 #include "SEGGER_RTT.h"
 #include "string.h"
 #include "math.h"
@@ -21,6 +21,14 @@
 
 #define sl_packed __attribute__((packed))
 
+/* 在 SRAM 中执行的函数（SL_RAMFUNC_ENABLE），免去 flash 等待周期。段名 .RamFunc：
+ * MDK 由 project.sct 放入 RW_IRAM_FUNC，GCC 由链接脚本放入 .data，均在启动时随 RW 数据从 flash 拷贝 */
+#if SL_RAMFUNC_ENABLE && !defined(SL_PORT_HOST)
+#define sl_ramfunc __attribute__((section(".RamFunc")))
+#else
+#define sl_ramfunc
+#endif
+
 /* 中断优先级 */
 #define SL_PRIO_HIGHEST 0
 #define SL_PRIO_LOWEST 15
@@ -49,31 +57,292 @@ void print_null(const char *sFormat, ...);
 
 #define SEGGER_RTT_printf(sFormat, ...) print_null(sFormat, ##__VA_ARGS__)
 
+#define sl_rtt_printf(idx, sFormat, ...) print_null(sFormat, ##__VA_ARGS__)
+
+#else
+
+/* 格式化后直接写入 RTT 上行缓冲区，整条只提交一次写偏移 */
+int sl_rtt_printf(unsigned idx, const char *sFormat, ...);
+
+#endif
+
+/* RTT 上行通道分配：文本日志、Flow 跟踪、变量遥测各用一个通道，互不挤占 */
+#define SL_RTT_CH_TEXT 0
+#define SL_RTT_CH_TRACE 1
+#define SL_RTT_CH_TELE 2
+
+/* 日志输出后端 */
+#define SL_BACKEND_RTT 0
+#define SL_BACKEND_UART 1
+
+/* 日志等级 */
+#define SL_LEVEL_NONE 0
+#define SL_LEVEL_ERROR 1
+#define SL_LEVEL_WARN 2
+#define SL_LEVEL_INFO 3
+#define SL_LEVEL_DEBUG 4
+
+/* 当前文件所属日志模块，可在包含 sloop.h 之前定义 */
+#ifndef SL_LOG_MODULE
+#define SL_LOG_MODULE SL_MOD_APP
+#endif
+
+/* 各模块运行期日志等级，可在调试器中直接修改 */
+extern uint8_t sl_log_level[SL_MOD_NUM];
+
+/* 设置模块运行期日志等级，module 为 -1 时设置全部模块 */
+void sl_log_set_level(int module, int level);
+
+/* 运行期过滤，打印语句以可变参数传入，避免其中的逗号被拆分 */
+#define sl_log_gate(level, module, ...)      \
+    do                                       \
+    {                                        \
+        if ((level) <= sl_log_level[module]) \
+        {                                    \
+            __VA_ARGS__;                     \
+        }                                    \
+    } while (0)
+
+/* 编译期过滤：低于 SL_LOG_LEVEL 的调用置于 if (0) 中，仍引用其参数（不产生未使用变量警告），开启优化后格式串与参数一并移除 */
+#define sl_log_off(module, ...) \
+    do                          \
+    {                           \
+        if (0)                  \
+        {                       \
+            __VA_ARGS__;        \
+        }                       \
+    } while (0)
+
+#if SL_LOG_LEVEL >= SL_LEVEL_ERROR
+#define sl_log_error_at(module, ...) sl_log_gate(SL_LEVEL_ERROR, module, __VA_ARGS__)
+#else
+#define sl_log_error_at(module, ...) sl_log_off(module, __VA_ARGS__)
+#endif
+
+#if SL_LOG_LEVEL >= SL_LEVEL_WARN
+#define sl_log_warn_at(module, ...) sl_log_gate(SL_LEVEL_WARN, module, __VA_ARGS__)
+#else
+#define sl_log_warn_at(module, ...) sl_log_off(module, __VA_ARGS__)
 #endif
 
+#if SL_LOG_LEVEL >= SL_LEVEL_INFO
+#define sl_log_info_at(module, ...) sl_log_gate(SL_LEVEL_INFO, module, __VA_ARGS__)
+#else
+#define sl_log_info_at(module, ...) sl_log_off(module, __VA_ARGS__)
+#endif
+
+#if SL_LOG_LEVEL >= SL_LEVEL_DEBUG
+#define sl_log_debug_at(module, ...) sl_log_gate(SL_LEVEL_DEBUG, module, __VA_ARGS__)
+#else
+#define sl_log_debug_at(module, ...) sl_log_off(module, __VA_ARGS__)
+#endif
+
+/* 二进制日志与异步日志都以格式描述符记录日志，延后到主机端或主循环中格式化 */
+#define SL_LOG_DEFER (SL_RTT_ENABLE && (SL_LOG_BINARY || SL_LOG_ASYNC))
+
+#if SL_LOG_RTT_LOCKLESS && !SL_LOG_ASYNC
+#error "SL_LOG_RTT_LOCKLESS requires SL_LOG_ASYNC"
+#endif
+
+/* 日志类型，二进制日志主机端据此还原颜色与前后缀 */
+enum
+{
+    SL_LOG_TEXT,
+    SL_LOG_FUNC,
+    SL_LOG_ERROR,
+    SL_LOG_FOCUS,
+    SL_LOG_WHITE,
+    SL_LOG_YELLOW,
+    SL_LOG_RAW,
+    SL_LOG_WARN,
+};
+
+#if SL_LOG_DEFER
+
+/* 目标端只记录格式描述符地址、时间戳与原始参数，二进制日志由主机端 tools/sl_log.py 还原文本 */
+
+/* 格式描述符，每个调用点一个，常量存放在 flash */
+typedef struct
+{
+    const char *fmt;
+
+    const char *func;
+
+    uint32_t type;
+
+} sl_log_desc_typ;
+
+void sl_log_write(const sl_log_desc_typ *desc, ...);
+
+/* 丢弃的日志条数：异步暂存队列满，或二进制日志写入时 RTT 通道满 */
+extern volatile uint32_t sl_log_drop;
+
+#define sl_log_bin(type, func, sFormat, ...)                               \
+    do                                                                     \
+    {                                                                      \
+        static const sl_log_desc_typ _sl_log_desc = {sFormat, func, type}; \
+                                                                           \
+        sl_log_write(&_sl_log_desc, ##__VA_ARGS__);                        \
+    } while (0)
+
+/* 系统打印（带时间戳） */
+#define _sl_prt_noFunc(sFormat, ...) sl_log_bin(SL_LOG_TEXT, NULL, sFormat, ##__VA_ARGS__)
+
+/* 带函数名的打印 */
+#define _sl_printf(sFormat, ...) sl_log_bin(SL_LOG_FUNC, __func__, sFormat, ##__VA_ARGS__)
+
+/* 错误日志 */
+#define _sl_error(sFormat, ...) sl_log_bin(SL_LOG_ERROR, __func__, sFormat, ##__VA_ARGS__)
+
+/* 白色高亮日志，带 === ==== */
+#define _sl_focus(sFormat, ...) sl_log_bin(SL_LOG_FOCUS, NULL, sFormat, ##__VA_ARGS__)
+
+/* 白色高亮日志 */
+#define _sl_prt_brWhite(sFormat, ...) sl_log_bin(SL_LOG_WHITE, NULL, sFormat, ##__VA_ARGS__)
+
+/* 黄色高亮日志 */
+#define _sl_prt_brYellow(sFormat, ...) sl_log_bin(SL_LOG_YELLOW, NULL, sFormat, ##__VA_ARGS__)
+
+/* 警告日志 */
+#define _sl_warn(sFormat, ...) sl_log_bin(SL_LOG_WARN, __func__, sFormat, ##__VA_ARGS__)
+
+/* 连续打印（末尾不带换行），用于不换行连续输出 */
+#define _sl_prt_noNewLine(sFormat, ...) sl_log_bin(SL_LOG_RAW, NULL, sFormat, ##__VA_ARGS__)
+
+#else
+
 /* 系统打印（带时间戳），RTT 简化版本 */
-#define sl_prt_noFunc(sFormat, ...) SEGGER_RTT_printf(0, RTT_CTRL_TEXT_GREEN "\n[%02d %02d:%02d:%02d.%03d] " RTT_CTRL_TEXT_YELLOW sFormat "\n" RTT_CTRL_RESET, \
-                                                      sl_get_tick() / 1000 / 60 / 60 / 24,                                                                     \
-                                                      sl_get_tick() / 1000 / 60 / 60 % 24,                                                                     \
-                                                      sl_get_tick() / 1000 / 60 % 60,                                                                          \
-                                                      sl_get_tick() / 1000 % 60,                                                                               \
-                                                      sl_get_tick() % 1000,                                                                                    \
-                                                      ##__VA_ARGS__)
+#define _sl_prt_noFunc(sFormat, ...) sl_rtt_printf(SL_RTT_CH_TEXT, RTT_CTRL_TEXT_GREEN "\n[%02d %02d:%02d:%02d.%03d] " RTT_CTRL_TEXT_YELLOW sFormat "\n" RTT_CTRL_RESET, \
+                                                  sl_get_tick() / 1000 / 60 / 60 / 24,                                                                                   \
+                                                  sl_get_tick() / 1000 / 60 / 60 % 24,                                                                                   \
+                                                  sl_get_tick() / 1000 / 60 % 60,                                                                                        \
+                                                  sl_get_tick() / 1000 % 60,                                                                                             \
+                                                  sl_get_tick() % 1000,                                                                                                  \
+                                                  ##__VA_ARGS__)
 
 /* 带函数名的打印 */
-#define sl_printf(sFormat, ...) sl_prt_noFunc(sFormat RTT_CTRL_TEXT_GREEN " <func: %s>" RTT_CTRL_RESET, ##__VA_ARGS__, __func__)
+#define _sl_printf(sFormat, ...) _sl_prt_noFunc(sFormat RTT_CTRL_TEXT_GREEN " <func: %s>" RTT_CTRL_RESET, ##__VA_ARGS__, __func__)
 
 /* 错误日志 */
-#define sl_error(sFormat, ...) sl_printf(RTT_CTRL_TEXT_BRIGHT_RED "[error] " sFormat RTT_CTRL_RESET, ##__VA_ARGS__)
+#define _sl_error(sFormat, ...) _sl_printf(RTT_CTRL_TEXT_BRIGHT_RED "[error] " sFormat RTT_CTRL_RESET, ##__VA_ARGS__)
+
+/* 警告日志 */
+#define _sl_warn(sFormat, ...) _sl_printf(RTT_CTRL_TEXT_BRIGHT_YELLOW "[warn] " sFormat RTT_CTRL_RESET, ##__VA_ARGS__)
 
 /* 白色高亮日志，带 === ==== */
-#define sl_focus(sFormat, ...) sl_prt_noFunc(RTT_CTRL_TEXT_BRIGHT_WHITE "=== " sFormat " ===" RTT_CTRL_RESET, ##__VA_ARGS__)
+#define _sl_focus(sFormat, ...) _sl_prt_noFunc(RTT_CTRL_TEXT_BRIGHT_WHITE "=== " sFormat " ===" RTT_CTRL_RESET, ##__VA_ARGS__)
 
 /* 白色高亮日志 */
-#define sl_prt_brWhite(sFormat, ...) sl_prt_noFunc(RTT_CTRL_TEXT_BRIGHT_WHITE sFormat RTT_CTRL_RESET, ##__VA_ARGS__)
+#define _sl_prt_brWhite(sFormat, ...) _sl_prt_noFunc(RTT_CTRL_TEXT_BRIGHT_WHITE sFormat RTT_CTRL_RESET, ##__VA_ARGS__)
 
 /* 黄色高亮日志 */
-#define sl_prt_brYellow(sFormat, ...) sl_prt_noFunc(RTT_CTRL_TEXT_BRIGHT_YELLOW sFormat RTT_CTRL_RESET, ##__VA_ARGS__)
+#define _sl_prt_brYellow(sFormat, ...) _sl_prt_noFunc(RTT_CTRL_TEXT_BRIGHT_YELLOW sFormat RTT_CTRL_RESET, ##__VA_ARGS__)
+
+/* 连续打印（末尾不带换行），用于不换行连续输出 */
+#define _sl_prt_noNewLine(sFormat, ...) sl_rtt_printf(SL_RTT_CH_TEXT, RTT_CTRL_TEXT_YELLOW sFormat RTT_CTRL_RESET, ##__VA_ARGS__, __func__)
+
+#endif
+
+
+/* 系统打印（带时间戳） */
+#define sl_prt_noFunc(sFormat, ...) sl_log_info_at(SL_LOG_MODULE, _sl_prt_noFunc(sFormat, ##__VA_ARGS__))
+
+/* 带函数名的打印 */
+#define sl_printf(sFormat, ...) sl_log_info_at(SL_LOG_MODULE, _sl_printf(sFormat, ##__VA_ARGS__))
+
+/* 错误日志 */
+#define sl_error(sFormat, ...) sl_log_error_at(SL_LOG_MODULE, _sl_error(sFormat, ##__VA_ARGS__))
+
+/* 警告日志 */
+#define sl_warn(sFormat, ...) sl_log_warn_at(SL_LOG_MODULE, _sl_warn(sFormat, ##__VA_ARGS__))
+
+/* 调试日志 */
+#define sl_debug(sFormat, ...) sl_log_debug_at(SL_LOG_MODULE, _sl_printf(sFormat, ##__VA_ARGS__))
+
+/* 白色高亮日志，带 === ==== */
+#define sl_focus(sFormat, ...) sl_log_info_at(SL_LOG_MODULE, _sl_focus(sFormat, ##__VA_ARGS__))
+
+/* 白色高亮日志 */
+#define sl_prt_brWhite(sFormat, ...) sl_log_info_at(SL_LOG_MODULE, _sl_prt_brWhite(sFormat, ##__VA_ARGS__))
+
+/* 黄色高亮日志 */
+#define sl_prt_brYellow(sFormat, ...) sl_log_info_at(SL_LOG_MODULE, _sl_prt_brYellow(sFormat, ##__VA_ARGS__))
+
+/* 连续打印（末尾不带换行），用于不换行连续输出 */
+#define sl_prt_noNewLine(sFormat, ...) sl_log_info_at(SL_LOG_MODULE, _sl_prt_noNewLine(sFormat, ##__VA_ARGS__))
+
+/* 限频/去重状态，每个调用点在宏内静态定义一份，互不干扰，首次使用时登记到链表供周期汇总 */
+typedef struct sl_log_limit
+{
+    const char *fmt;
+
+    /* 参数哈希，限频时为 0 */
+    uint32_t hash;
+
+    /* 上次输出时间 */
+    uint32_t tick;
+
+    int period;
+
+    /* 被抑制的条数 */
+    uint16_t count;
+
+    char linked;
+    struct sl_log_limit *next;
+
+} sl_log_limit_typ;
+
+/* 限频/去重检查，返回 1 表示应输出 */
+char sl_log_limit(sl_log_limit_typ *e, const char *fmt, int period, uint32_t hash);
+
+/* 限频打印：同一调用点每 period_ms 最多输出一条，其余计数，之后汇总 "repeated N times" */
+#define sl_printf_ratelimit(period_ms, sFormat, ...)                    \
+    sl_log_info_at(SL_LOG_MODULE, static sl_log_limit_typ _sl_limit;    \
+                   if (sl_log_limit(&_sl_limit, sFormat, period_ms, 0)) \
+                       _sl_printf(sFormat, ##__VA_ARGS__))
+
+#define sl_error_ratelimit(period_ms, sFormat, ...)                      \
+    sl_log_error_at(SL_LOG_MODULE, static sl_log_limit_typ _sl_limit;    \
+                    if (sl_log_limit(&_sl_limit, sFormat, period_ms, 0)) \
+                        _sl_error(sFormat, ##__VA_ARGS__))
+
+/* 去重打印：同一调用点内容相同的日志在 SL_LOG_DEDUP_MS 内只输出一次，内容变化或周期结束时汇总重复次数。
+ * 参数只求值一次，由 sl_log_dedup 先计算哈希再用同一组参数输出；
+ * 代价是每次调用（包括被抑制的）都扫描一遍格式串并哈希全部参数，%s 逐字节，被抑制时不格式化 */
+#if SL_LOG_DEFER
+
+void sl_log_dedup(sl_log_limit_typ *limit, const sl_log_desc_typ *desc, ...);
+
+#define _sl_dedup(type, sFormat, ...)                                          \
+    do                                                                         \
+    {                                                                          \
+        static const sl_log_desc_typ _sl_log_desc = {sFormat, __func__, type}; \
+        static sl_log_limit_typ _sl_limit;                                     \
+                                                                               \
+        sl_log_dedup(&_sl_limit, &_sl_log_desc, ##__VA_ARGS__);                \
+    } while (0)
+
+#elif SL_RTT_ENABLE
+
+void sl_log_dedup(sl_log_limit_typ *limit, int type, const char *func, const char *sFormat, ...);
+
+#define _sl_dedup(type, sFormat, ...)                                     \
+    do                                                                    \
+    {                                                                     \
+        static sl_log_limit_typ _sl_limit;                                \
+                                                                          \
+        sl_log_dedup(&_sl_limit, type, __func__, sFormat, ##__VA_ARGS__); \
+    } while (0)
+
+#else
+
+#define _sl_dedup(type, sFormat, ...) print_null(sFormat, ##__VA_ARGS__)
+
+#endif
+
+#define sl_printf_dedup(sFormat, ...) sl_log_info_at(SL_LOG_MODULE, _sl_dedup(SL_LOG_FUNC, sFormat, ##__VA_ARGS__))
+
+#define sl_error_dedup(sFormat, ...) sl_log_error_at(SL_LOG_MODULE, _sl_dedup(SL_LOG_ERROR, sFormat, ##__VA_ARGS__))
 
 /* 打印变量 */
 #define sl_prt_var(var) sl_printf(#var " = %d", (int)var)
@@ -87,8 +356,240 @@ void print_null(const char *sFormat, ...);
 /* 打印浮点数 */
 #define sl_prt_float(var) sl_printf(#var " = %d.%02d", (int)var, abs((int)(var * 100) % 100))
 
-/* 连续打印（末尾不带换行），用于不换行连续输出 */
-#define sl_prt_noNewLine(sFormat, ...) SEGGER_RTT_printf(0, RTT_CTRL_TEXT_YELLOW sFormat RTT_CTRL_RESET, ##__VA_ARGS__, __func__)
+/* ============================================================== */
+/* 变量示波：按固定周期采样已登记变量，二进制写入 RTT 遥测通道 */
+
+/* 变量类型 */
+enum
+{
+    SL_SCOPE_U8,
+    SL_SCOPE_S8,
+    SL_SCOPE_U16,
+    SL_SCOPE_S16,
+    SL_SCOPE_U32,
+    SL_SCOPE_S32,
+    SL_SCOPE_F32,
+};
+
+#if SL_SCOPE_ENABLE
+
+#if !SL_RTT_ENABLE || !SL_RTT_TELE_SIZE
+#error "SL_SCOPE_ENABLE requires SL_RTT_ENABLE and SL_RTT_TELE_SIZE"
+#endif
+
+/* 登记变量，name 供主机端显示，已登记则更新。成功返回1 */
+char sl_scope_add(const char *name, volatile void *addr, int type);
+/* 移除变量 */
+void sl_scope_remove(volatile void *addr);
+
+/* 开始采样，每 ms 毫秒一次 */
+void sl_scope_start(int ms);
+/* 停止采样 */
+void sl_scope_stop(void);
+
+#else
+
+#define sl_scope_add(name, addr, type) 0
+#define sl_scope_remove(addr)
+#define sl_scope_start(ms)
+#define sl_scope_stop()
+
+#endif
+
+/* 登记变量，以变量名作为名称，举例：sl_scope_var(speed, SL_SCOPE_S16) */
+#define sl_scope_var(var, type) sl_scope_add(#var, &(var), type)
+
+/* ============================================================== */
+/* CPU 负载 */
+
+/* CPU 负载，单位 0.1%：最近 100ms、报告期内峰值与平均 */
+typedef struct
+{
+    uint16_t now;
+
+    uint16_t peak;
+
+    uint16_t avg;
+
+} sl_load_typ;
+
+/* 任务计时帧，内核在调用任务前后记录 */
+typedef struct
+{
+    uint32_t start;
+
+    uint32_t child;
+
+} sl_load_frame_typ;
+
+void sl_load_enter(sl_load_frame_typ *frame);
+void sl_load_exit(sl_load_frame_typ *frame, pfunc task, char poll);
+void sl_load_skip(uint32_t cycles);
+
+/* 延迟直方图桶数，第 i 桶统计 [2^i, 2^(i+1)) 个周期，末桶含更长的 */
+#define SL_LATENCY_BUCKETS 24
+
+/* 延迟直方图，单位为周期 */
+typedef struct
+{
+    uint32_t hist[SL_LATENCY_BUCKETS];
+
+    /* 样本数，达到 2^31 时与各桶一起减半 */
+    uint32_t count;
+
+    /* 最大值、发生时刻 ms 与此前耗时最长的任务 */
+    uint32_t max;
+    uint32_t max_tick;
+    pfunc culprit;
+
+    /* p99 上界，每 100ms 更新 */
+    uint32_t p99;
+
+} sl_latency_hist_typ;
+
+/* 延迟统计，可在调试器中直接查看 sl_latency */
+typedef struct
+{
+    /* 主循环相邻两轮的间隔 */
+    sl_latency_hist_typ loop;
+
+    /* tick 中断到 soft_timer 开始运行的延迟 */
+    sl_latency_hist_typ timer;
+
+    /* 每 us 周期数，每 100ms 校准 */
+    uint32_t cycle_us;
+
+} sl_latency_typ;
+
+extern sl_latency_typ sl_latency;
+
+/* ============================================================== */
+/* 按负载调频 */
+
+#if SL_GOV_ENABLE
+
+#if SL_GOV_DOWN * 2 >= SL_GOV_UP
+#error "SL_GOV_DOWN must be below half of SL_GOV_UP"
+#endif
+
+/* 1：保持全速（如依赖 HCLK 的外设工作期间），0：恢复按负载调频 */
+void sl_gov_full(char on);
+/* 当前 HCLK Hz */
+uint32_t sl_gov_hclk(void);
+
+/* 切换 HCLK 为全速的 1/div 并重启 SysTick（关中断调用），不切换返回 0，移植层可重新实现 */
+char sl_gov_clock(uint32_t div);
+/* 时钟切换后调用，以 HCLK/PCLK 为时钟的外设在此重新配置，用户可重新实现 */
+void sl_gov_notify(uint32_t hclk);
+
+#else
+
+#define sl_gov_full(on)
+#define sl_gov_hclk() ((SysTick->LOAD + 1) * 1000)
+
+#endif
+
+/* ============================================================== */
+/* 过载降级 */
+
+/* 降级类别：控制类任务保持 NONE，诊断、统计等低优先级任务声明为 STRETCH 或 PAUSE */
+enum
+{
+    /* 不降级 */
+    SL_SHED_NONE,
+
+    /* 周期任务周期拉长 SL_SHED_FACTOR 倍；并行任务暂停 */
+    SL_SHED_STRETCH,
+
+    /* 周期任务与并行任务都暂停 */
+    SL_SHED_PAUSE,
+};
+
+#if SL_SHED_ENABLE
+
+#if SL_SHED_OFF >= SL_SHED_ON
+#error "SL_SHED_OFF must be below SL_SHED_ON"
+#endif
+
+/* 声明任务的降级类别，SL_SHED_NONE 为取消声明 */
+void sl_shed_set(pfunc task, char cls);
+/* 当前是否处于降级状态 */
+char sl_shed_active(void);
+
+#else
+
+#define sl_shed_set(task, cls)
+#define sl_shed_active() 0
+
+#endif
+
+/* ============================================================== */
+/* 定时器迟到统计 */
+
+/* 定时器类型 */
+enum
+{
+    SL_TIMER_TIMEOUT,
+    SL_TIMER_CYCLE,
+    SL_TIMER_MULTIPLE,
+};
+
+/* 定时器迟到统计，迟到为触发时刻与到期时刻之差，单位 ms */
+typedef struct
+{
+    pfunc task;
+
+    uint8_t type;
+
+    /* 定时 ms */
+    int period;
+
+    /* 触发次数、迟到之和 */
+    uint32_t count;
+    uint32_t sum;
+
+    uint16_t min;
+    uint16_t max;
+
+} sl_timer_stat_typ;
+
+/* ============================================================== */
+/* 栈与注册表峰值 */
+
+/* 栈与注册表占用峰值，可在调试器中直接查看 sl_mem */
+typedef struct
+{
+    /* 栈大小与峰值使用字节数 */
+    uint32_t stack_size;
+    uint32_t stack_peak;
+
+    /* 各注册表占用峰值，对应 SL_xxx_LIMIT */
+    uint8_t timeout;
+    uint8_t cycle;
+    uint8_t multiple;
+    uint8_t parallel;
+    uint8_t once;
+    uint8_t flow_child;
+    uint8_t sem_wait;
+    uint8_t scope_var;
+
+} sl_mem_typ;
+
+extern sl_mem_typ sl_mem;
+
+/* 获取栈区间 [bottom, top)，默认取启动文件中的 STACK 段，可重新实现 */
+void sl_stack_region(uint32_t **bottom, uint32_t **top);
+
+/* 在 SRAM 中执行的代码字节数（sl_ramfunc），可重新实现 */
+uint32_t sl_ramfunc_size(void);
+
+/* 登记到注册表第 i 项时更新峰值。注册表均取第一个空位，第 i 项被占用时前 i 项必然都被占用 */
+#define sl_mem_peak(name, i)       \
+    do                             \
+    {                              \
+        if ((i) >= sl_mem.name)    \
+            sl_mem.name = (i) + 1; \
+    } while (0)
 
 /* ============================================================== */
 /* 互斥任务相关服务 */
@@ -100,10 +601,10 @@ extern char sl_free;
 void sl_load_new_task(void);
 
 /* 任务初始化宏 */
-#define SL_INIT                         \
-    if (sl_init == 1)                   \
-    {                                   \
-        sl_focus("enter %s", __func__); \
+#define SL_INIT                                                          \
+    if (sl_init == 1)                                                    \
+    {                                                                    \
+        sl_log_debug_at(SL_MOD_KERNEL, _sl_focus("enter %s", __func__)); \
         sl_init = 0;
 
 /* 任务释放宏 */
@@ -112,12 +613,12 @@ void sl_load_new_task(void);
     if (sl_free == 1) \
     {
 
-#define SL_RUN                     \
-    sl_focus("exit %s", __func__); \
-    sl_load_new_task();            \
-    sl_init = 1;                   \
-    sl_free = 0;                   \
-    return;                        \
+#define SL_RUN                                                      \
+    sl_log_debug_at(SL_MOD_KERNEL, _sl_focus("exit %s", __func__)); \
+    sl_load_new_task();                                             \
+    sl_init = 1;                                                    \
+    sl_free = 0;                                                    \
+    return;                                                         \
     }
 
 /* ============================================================== */
@@ -145,17 +646,27 @@ enum
     FLOW_FREE,
     FLOW_RUN,
     FLOW_IDLE,
+    FLOW_EXITED,
 };
 
+/* Flow 退出状态：0 正常结束，FLOW_STOPPED 被外部停止，其余由用户通过 FLOW_RETURN 定义 */
+#define FLOW_OK 0
+#define FLOW_STOPPED (-1)
+
 /* Flow 状态定义 */
-#define FLOW_STATE_DEFINE(flow_name) uint32_t flow_state_##flow_name;
-#define FLOW_STATE_DECLARE(flow_name) extern uint32_t flow_state_##flow_name;
+#define FLOW_STATE_DEFINE(flow_name)  \
+    uint32_t flow_state_##flow_name; \
+    int flow_ret_##flow_name;
+#define FLOW_STATE_DECLARE(flow_name)       \
+    extern uint32_t flow_state_##flow_name; \
+    extern int flow_ret_##flow_name;
 
 /* Flow 启动 */
 #define FLOW_START(flow_name)               \
     do                                      \
     {                                       \
         flow_state_##flow_name = FLOW_INIT; \
+        flow_ret_##flow_name = FLOW_OK;     \
         sl_task_start(flow_name);           \
     } while (0);
 
@@ -163,38 +674,55 @@ enum
 #define FLOW_STOP(flow_name) flow_state_##flow_name = FLOW_FREE
 
 /* Flow 内部上下文 */
-#define SL_FLOW_CONTEXT(flow_name)                  \
-    static uint32_t _flow_tick;                   \
-    static uint32_t _flow_state;                  \
-    static uint32_t _state_backup;                \
-    if (flow_state_##flow_name == FLOW_INIT)      \
-    {                                             \
-        _flow_state = FLOW_INIT;                  \
-        flow_state_##flow_name = FLOW_IDLE;       \
-    }                                             \
-    else if (flow_state_##flow_name == FLOW_FREE) \
-    {                                             \
-        _flow_state = FLOW_FREE;                  \
-        flow_state_##flow_name = FLOW_IDLE;       \
+#define SL_FLOW_CONTEXT(flow_name)                               \
+    static uint32_t _flow_tick;                                  \
+    static uint32_t _flow_state;                                 \
+    static uint32_t _state_backup;                               \
+    static uint32_t _flow_signal;                                \
+    static uint32_t *const _flow_self = &flow_state_##flow_name; \
+    static int *const _flow_ret = &flow_ret_##flow_name;         \
+    SL_FLOW_TRACE_CONTEXT                                        \
+    /* 简单 Flow 用不到全部上下文 */                             \
+    (void)_flow_tick;                                            \
+    (void)_flow_signal;                                          \
+    (void)_flow_ret;                                             \
+    if (flow_state_##flow_name == FLOW_INIT)                     \
+    {                                                            \
+        SL_FLOW_TRACE(FLOW_IDLE, FLOW_INIT, FLOW_WHY_START);     \
+        sl_sim_busy();                                           \
+        _flow_state = FLOW_INIT;                                 \
+        flow_state_##flow_name = FLOW_IDLE;                      \
+    }                                                            \
+    else if (flow_state_##flow_name == FLOW_FREE)                \
+    {                                                            \
+        SL_FLOW_TRACE(_flow_state, FLOW_FREE, FLOW_WHY_STOP);    \
+        sl_sim_busy();                                           \
+        _flow_state = FLOW_FREE;                                 \
+        flow_state_##flow_name = FLOW_IDLE;                      \
+        flow_ret_##flow_name = FLOW_STOPPED;                     \
     }
 
 /* 初始化区 */
-#define SL_FLOW_INIT       \
+#define SL_FLOW_INIT     \
     switch (_flow_state) \
     {                    \
     case FLOW_INIT:      \
     {                    \
-        sl_printf("FLOW_INIT");
+        sl_log_debug_at(SL_MOD_FLOW, _sl_printf("FLOW_INIT"));
 
 /* 清理区 */
-#define SL_FLOW_FREE(flow_name)    \
-    _flow_state = FLOW_RUN;      \
-    break;                       \
-    }                            \
-    case FLOW_FREE:              \
-    {                            \
-        sl_task_stop(flow_name); \
-        sl_printf("FLOW_FREE");
+#define SL_FLOW_FREE(flow_name)                               \
+    SL_FLOW_TRACE(FLOW_INIT, FLOW_RUN, FLOW_WHY_NONE);        \
+    _flow_state = FLOW_RUN;                                   \
+    break;                                                    \
+    }                                                         \
+    case FLOW_FREE:                                           \
+    {                                                         \
+        sl_task_stop(flow_name);                              \
+        flow_release(_flow_self);                             \
+        flow_state_##flow_name = FLOW_EXITED;                 \
+        SL_FLOW_TRACE(FLOW_FREE, FLOW_EXITED, FLOW_WHY_NONE); \
+        sl_log_debug_at(SL_MOD_FLOW, _sl_printf("FLOW_FREE"));
 
 /* 运行区 */
 #define SL_FLOW_RUN            \
@@ -210,58 +738,342 @@ enum
     }             \
     }
 
+/* ===================== */
+/*      FLOW 跟踪        */
+/* ===================== */
+
+/* 挂起原因 */
+enum
+{
+    FLOW_WHY_NONE,
+    FLOW_WHY_UNTIL,
+    FLOW_WHY_TIME,
+    FLOW_WHY_EVENT,
+    FLOW_WHY_CHAN,
+    FLOW_WHY_SELECT,
+    FLOW_WHY_TAKE,
+    FLOW_WHY_CALL,
+    FLOW_WHY_RESUME,
+    FLOW_WHY_START,
+    FLOW_WHY_STOP,
+    FLOW_WHY_EXIT,
+};
+
+#if SL_TRACE_ENABLE
+
+/* 记录一次 Flow 状态迁移 */
+void sl_trace_flow(uint32_t *flow, uint32_t from, uint32_t to, uint8_t why);
+
+#define SL_FLOW_TRACE_CONTEXT static char _flow_parked;
+
+#define SL_FLOW_TRACE(from, to, why) sl_trace_flow(_flow_self, from, to, why)
+
+/* 首次挂起时记录，挂起期间不重复记录 */
+#define SL_FLOW_TRACE_PARK(why)                                    \
+    if (_flow_parked == 0)                                         \
+    {                                                              \
+        _flow_parked = 1;                                          \
+        sl_trace_flow(_flow_self, _state_backup, _flow_state, why); \
+    }
+
+#define SL_FLOW_TRACE_RESUME()                                                  \
+    if (_flow_parked)                                                           \
+    {                                                                           \
+        _flow_parked = 0;                                                       \
+        sl_trace_flow(_flow_self, _flow_state, _state_backup, FLOW_WHY_RESUME); \
+    }
+
+#else
+
+#define SL_FLOW_TRACE_CONTEXT
+#define SL_FLOW_TRACE(from, to, why)
+#define SL_FLOW_TRACE_PARK(why)
+#define SL_FLOW_TRACE_RESUME()
+
+#endif
+
 /* ===================== */
 /*      FLOW 原语        */
 /* ===================== */
 
 #define __FLOW_LINE__ (FLOW_OFFSET + 1024 + __LINE__)
 
-/* 条件等待（核心原语） */
-#define FLOW_UNTIL(cond)             \
+/* 条件等待（核心原语），why 为挂起原因，供跟踪记录 */
+#define FLOW_UNTIL_WHY(cond, why)    \
     do                               \
     {                                \
         _state_backup = _flow_state; \
         _flow_state = __FLOW_LINE__; \
     case __FLOW_LINE__:              \
         if (!(cond))                 \
+        {                            \
+            SL_FLOW_TRACE_PARK(why); \
             return;                  \
+        }                            \
+        SL_FLOW_TRACE_RESUME();      \
+        sl_sim_busy();               \
         _flow_state = _state_backup; \
     } while (0);
 
+/* 条件等待 */
+#define FLOW_UNTIL(cond) FLOW_UNTIL_WHY(cond, FLOW_WHY_UNTIL)
+
+/* 自 _flow_tick 起已过 ms，仿真时同时登记到期时刻 */
+#define FLOW_ELAPSED(ms) (sl_sim_deadline(_flow_tick + (uint32_t)(ms)), (uint32_t)(sl_get_tick() - _flow_tick) >= (uint32_t)(ms))
+
 /* 时间等待 */
-#define FLOW_WAIT(ms)                                              \
-    do                                                             \
-    {                                                              \
-        _flow_tick = sl_get_tick();                                \
-        FLOW_UNTIL((uint32_t)(sl_get_tick() - _flow_tick) >= (ms)) \
+#define FLOW_WAIT(ms)                                   \
+    do                                                  \
+    {                                                   \
+        _flow_tick = sl_get_tick();                     \
+        FLOW_UNTIL_WHY(FLOW_ELAPSED(ms), FLOW_WHY_TIME) \
     } while (0);
 
+/* 等待超时结果 */
+#define FLOW_TIMEOUT 0
+
+/* 不设超时，永久等待 */
+#define FLOW_FOREVER (-1)
+
+/* 事件/通道发送计数，多路等待仅在其变化时重新检查等待源 */
+extern volatile uint32_t flow_signal;
+
 /* 事件定义 */
 #define FLOW_EVENT_DEFINE(id) char flow_event_##id;
 #define FLOW_EVENT_DECLARE(id) extern char flow_event_##id;
 
 /* 发送事件 */
-#define FLOW_SEND_EVENT(id) flow_event_##id = 1;
+#define FLOW_SEND_EVENT(id)  \
+    do                       \
+    {                        \
+        flow_event_##id = 1; \
+        flow_signal++;       \
+    } while (0);
 
 /* 等待事件（消费型） */
-#define FLOW_WAIT_EVENT(id)          \
-    do                               \
-    {                                \
-        FLOW_UNTIL(flow_event_##id); \
-        flow_event_##id = 0;         \
+#define FLOW_WAIT_EVENT(id)                              \
+    do                                                   \
+    {                                                    \
+        FLOW_UNTIL_WHY(flow_event_##id, FLOW_WHY_EVENT); \
+        flow_event_##id = 0;                             \
+    } while (0);
+
+/* 带超时的事件等待（消费型），result：1 事件到达，FLOW_TIMEOUT 超时 */
+#define FLOW_WAIT_EVENT_TIMEOUT(id, ms, result)                             \
+    do                                                                      \
+    {                                                                       \
+        _flow_tick = sl_get_tick();                                         \
+        FLOW_UNTIL_WHY(flow_event_##id || FLOW_ELAPSED(ms), FLOW_WHY_EVENT) \
+        result = flow_event_##id ? 1 : FLOW_TIMEOUT;                        \
+        flow_event_##id = 0;                                                \
+    } while (0);
+
+/* 通道：uint32_t 消息环形队列，容量不超过 127，可在中断中发送 */
+typedef struct
+{
+    uint32_t *buf;
+
+    uint8_t size;
+
+    uint8_t head;
+
+    uint8_t tail;
+
+    /* 消息数量，非0即就绪 */
+    volatile char count;
+
+} flow_chan_typ;
+
+/* 通道定义，size 不在 1~127 时缓冲区长度为负，编译报错 */
+#define FLOW_CHAN_DEFINE(id, size)                                                  \
+    static uint32_t flow_chan_buf_##id[(size) >= 1 && (size) <= 127 ? (size) : -1]; \
+    flow_chan_typ flow_chan_##id = {flow_chan_buf_##id, size};
+#define FLOW_CHAN_DECLARE(id) extern flow_chan_typ flow_chan_##id;
+
+/* 通道发送/接收，成功返回1，满/空返回0 */
+char flow_chan_send(flow_chan_typ *chan, uint32_t msg);
+char flow_chan_recv(flow_chan_typ *chan, uint32_t *msg);
+
+/* 发送消息 */
+#define FLOW_CHAN_SEND(id, msg) flow_chan_send(&flow_chan_##id, msg)
+
+/* 等待并接收消息，msg 需为静态或全局 uint32_t */
+#define FLOW_CHAN_RECV(id, msg) FLOW_UNTIL_WHY(flow_chan_recv(&flow_chan_##id, &(msg)), FLOW_WHY_CHAN)
+
+/* 多路等待源 */
+typedef struct
+{
+    /* 就绪标志 */
+    volatile char *ready;
+
+    /* 选中后是否清除：事件由等待方消费，通道由接收方消费 */
+    char consume;
+
+} flow_src_typ;
+
+/* 等待源：事件 / 通道 */
+#define FLOW_ON_EVENT(id) {&flow_event_##id, 1}
+#define FLOW_ON_CHAN(id) {&flow_chan_##id.count, 0}
+
+/* 检查等待源，返回首个就绪源序号（从1开始），均未就绪返回 FLOW_TIMEOUT */
+int flow_select(flow_src_typ *src, int num);
+
+#define FLOW_SRC_NUM(...) (int)(sizeof((flow_src_typ[]){__VA_ARGS__}) / sizeof(flow_src_typ))
+
+/* 多路等待：任一等待源就绪或超时即恢复，只占一个挂起点
+ * result：就绪源序号（从1开始），超时为 FLOW_TIMEOUT；ms 为 FLOW_FOREVER 时不超时
+ * 例：FLOW_SELECT(r, 500, FLOW_ON_EVENT(evt_ack), FLOW_ON_CHAN(ch_rx)); */
+#define FLOW_SELECT(result, ms, ...)                                                                                           \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        _flow_tick = sl_get_tick();                                                                                            \
+        _flow_signal = flow_signal - 1;                                                                                        \
+        FLOW_UNTIL_WHY((_flow_signal != flow_signal &&                                                                         \
+                        (_flow_signal = flow_signal,                                                                           \
+                         (result = flow_select((flow_src_typ[]){__VA_ARGS__}, FLOW_SRC_NUM(__VA_ARGS__))) != FLOW_TIMEOUT)) || \
+                       ((int)(ms) >= 0 && FLOW_ELAPSED(ms) && ((result = FLOW_TIMEOUT), 1)),                                   \
+                       FLOW_WHY_SELECT)                                                                                        \
     } while (0);
 
 /* Flow 内部停止 */
-#define FLOW_EXIT()              \
-    do                           \
-    {                            \
-        _flow_state = FLOW_FREE; \
-        return;                  \
+#define FLOW_EXIT()                                           \
+    do                                                        \
+    {                                                         \
+        SL_FLOW_TRACE(_flow_state, FLOW_FREE, FLOW_WHY_EXIT); \
+        sl_sim_busy();                                        \
+        _flow_state = FLOW_FREE;                              \
+        return;                                               \
+    } while (0);
+
+/* Flow 内部停止并返回退出状态，供 FLOW_CALL 的调用方获取 */
+#define FLOW_RETURN(status)  \
+    do                       \
+    {                        \
+        *_flow_ret = status; \
+        FLOW_EXIT();         \
     } while (0);
 
 /* 业务状态机跳转 */
 #define FLOW_GOTO(case_id) _flow_state = case_id;
 
+/* ===================== */
+/*      层级 Flow        */
+/* ===================== */
+
+/* 挂接子 Flow，父 Flow 停止时自动停止子 Flow */
+void flow_link(uint32_t *parent, uint32_t *child);
+/* Flow 退出时解除挂接，并停止其全部子 Flow */
+void flow_release(uint32_t *flow);
+
+/* 启动子 Flow，随当前 Flow 一起停止 */
+#define FLOW_SPAWN(child)                           \
+    do                                              \
+    {                                               \
+        FLOW_START(child);                          \
+        flow_link(_flow_self, &flow_state_##child); \
+    } while (0);
+
+/* 调用子 Flow 并等待其退出，status 为子 Flow 的退出状态 */
+#define FLOW_CALL(child, status)                                          \
+    do                                                                    \
+    {                                                                     \
+        FLOW_SPAWN(child);                                                \
+        FLOW_UNTIL_WHY(flow_state_##child == FLOW_EXITED, FLOW_WHY_CALL); \
+        status = flow_ret_##child;                                        \
+    } while (0);
+
+/* ============================================================== */
+/* 信号量 / 互斥量 */
+
+/*
+ * 等待者不会被释放者唤醒：Flow 与互斥任务每轮主循环重新尝试获取，按队列顺序决定谁先得到，
+ * 释放后最迟一轮主循环被队首取得。
+ */
+
+/* 等待者唤醒顺序 */
+#define SL_SEM_FIFO 0
+#define SL_SEM_PRIO 1
+
+/* 获取失败：等待队列已满或互斥量嵌套获取，已报告错误，不再等待 */
+#define SL_SEM_FAIL (-1)
+
+/* 信号量 */
+typedef struct sl_sem
+{
+    /* 可用数量，互斥量 1：空闲 0：被持有 */
+    volatile int count;
+
+    /* 数量上限 */
+    int max;
+
+    /* 1：互斥量 */
+    char mutex;
+
+    /* 唤醒顺序：SL_SEM_FIFO / SL_SEM_PRIO */
+    char order;
+
+    /* 等待队列，队首优先获取，等待者以 Flow 状态变量地址标识 */
+    uint32_t *wait_id[SL_SEM_WAIT_LIMIT];
+    uint8_t wait_prio[SL_SEM_WAIT_LIMIT];
+    uint8_t wait_num;
+
+    /* ===诊断=== */
+
+    /* 互斥量持有者及获取时间 */
+    uint32_t *owner;
+    uint32_t owner_tick;
+
+    /* 最长持有时间 ms */
+    uint32_t hold_max;
+
+    /* 等待队列深度高水位 */
+    uint8_t wait_max;
+
+    /* 超时次数 */
+    uint16_t timeout_count;
+
+    /* 已登记到信号量链表 */
+    char linked;
+    struct sl_sem *next;
+
+} sl_sem_typ;
+
+/* 信号量定义：初值，上限，唤醒顺序 */
+#define SL_SEM_DEFINE(name, init, max, order) sl_sem_typ name = {init, max, 0, order};
+/* 互斥量定义 */
+#define SL_MUTEX_DEFINE(name, order) sl_sem_typ name = {1, 1, 1, order};
+#define SL_SEM_DECLARE(name) extern sl_sem_typ name;
+
+/* 互斥任务作为等待者/持有者时的标识 */
+extern uint32_t sl_sem_task_id;
+
+/* 尝试获取，未获取则按顺序排队，仅队首可获取。成功返回1，等待中返回0，失败返回 SL_SEM_FAIL */
+int sl_sem_try(sl_sem_typ *sem, uint32_t *id, int prio);
+/* 超时放弃等待，退出等待队列并计入超时次数 */
+void sl_sem_cancel(sl_sem_typ *sem, uint32_t *id);
+/* 释放，id 为释放者（互斥量校验持有者） */
+void sl_sem_release(sl_sem_typ *sem, uint32_t *id);
+/* Flow 退出时，退出全部等待队列并释放其持有的互斥量 */
+void sl_sem_drop(uint32_t *id);
+
+/* Flow 按优先级获取信号量/互斥量，result（int）：1 获取成功，FLOW_TIMEOUT 超时，SL_SEM_FAIL 失败 */
+#define FLOW_TAKE_PRIO(sem, prio, ms, result)                             \
+    do                                                                    \
+    {                                                                     \
+        _flow_tick = sl_get_tick();                                       \
+        FLOW_UNTIL_WHY((result = sl_sem_try(&(sem), _flow_self, prio)) || \
+                       ((int)(ms) >= 0 && FLOW_ELAPSED(ms)),              \
+                       FLOW_WHY_TAKE)                                     \
+        if (result == FLOW_TIMEOUT)                                       \
+            sl_sem_cancel(&(sem), _flow_self);                            \
+    } while (0);
+
+/* Flow 获取信号量/互斥量，默认优先级 */
+#define FLOW_TAKE(sem, ms, result) FLOW_TAKE_PRIO(sem, SL_PRIO_DEFAULT, ms, result)
+
+/* Flow 释放信号量/互斥量 */
+#define FLOW_GIVE(sem) sl_sem_release(&(sem), _flow_self)
+
 #endif /* __sl_common_H */
 
 /*********************************** END OF FILE ***********************************/
@@ -22,9 +22,16 @@ void sl_tick_irq(void);
 
 /* 获取时间戳 */
 uint32_t sl_get_tick(void);
+/* 获取周期计数时间戳，自由回绕，用于测量短时间间隔 */
+uint32_t sl_get_cycle(void);
 /* 阻塞式延时 */
 void sl_delay(int ms);
 
+/* 阻塞等待中让出：运行一轮除调用者以外的并行任务。嵌套、中断中或关中断时不运行，返回 0 */
+char sl_yield(void);
+/* 获取并行任务轮询轮数，两次获取之间不变说明期间没有回到调度器 */
+uint32_t sl_get_round(void);
+
 /* 超时任务 */
 void sl_timeout_start(int ms, pfunc task);
 void sl_timeout_stop(pfunc task);
@@ -59,6 +66,46 @@ void sl_wait_continue(void);
 /* 获取等待状态 */
 char sl_is_waiting(void);
 
+#if SL_TIMER_STAT_ENABLE
+/* 遍历定时器迟到统计：it 从 0 开始，返回下一位置，遍历结束返回 -1
+ * 举例：for (int it = 0; (it = sl_timer_stat_next(it, &stat)) >= 0;) */
+int sl_timer_stat_next(int it, sl_timer_stat_typ *stat);
+/* 打印各定时器迟到统计 */
+void sl_timer_report(void);
+/* 清空定时器迟到统计 */
+void sl_timer_stat_reset(void);
+#else
+#define sl_timer_stat_next(it, stat) (-1)
+#define sl_timer_report()
+#define sl_timer_stat_reset()
+#endif
+
+/* 打印栈与各注册表占用峰值 */
+void sl_mem_report(void);
+
+/* 运行调度器微基准，结果以 JSON 经 RTT 通道0输出。须在注册表为空时调用，SL_BENCH_ENABLE 时由 sloop_init 调用 */
+void sl_bench_run(void);
+
+/* 获取 CPU 负载 */
+void sl_get_load(sl_load_typ *load);
+/* 打印 CPU 负载与各任务占比，并开始新的峰值/平均统计 */
+void sl_load_report(void);
+
+#if SL_LATENCY_ENABLE
+/* 打印主循环与软件定时器延迟的最大值、p99、肇事任务与直方图 */
+void sl_latency_report(void);
+/* 清空延迟统计 */
+void sl_latency_reset(void);
+#else
+#define sl_latency_report()
+#define sl_latency_reset()
+#endif
+
+/* 获取信号量/互斥量（只能在互斥任务中使用），等待期间并行任务照常运行。1：获取成功, 0：超时、等待被中断或获取失败 */
+char sl_sem_take(sl_sem_typ *sem, int ms);
+/* 释放信号量/互斥量，信号量可在中断中释放 */
+void sl_sem_give(sl_sem_typ *sem);
+
 #endif /* __sloop_H */
 
 /************************** END OF FILE **************************/
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+sl_bench: compare two sloop scheduler benchmark results.
+
+The benchmark (project/user/sloop/kernel/sl_bench.c) writes one JSON object to
+RTT channel 0, either from the host build
+
+    ./project/host/sloop_bench > new.json
+
+or on target with SL_BENCH_ENABLE set to 1, in which case the channel 0 capture
+also holds the normal log; the JSON object is picked out of it. A result with
+lines dropped while waiting for RTT space ("dropped" non-zero) is rejected.
+Compare a baseline with a new run:
+
+    python3 tools/sl_bench.py base.json new.json --fail 10
+
+For every operation the median cycles at fill level 1 and at the full registry
+are printed with the relative change of the mean over all fill levels. The RAM
+used by code executed from SRAM (SL_RAMFUNC_ENABLE) is printed for both runs,
+so a flash/RAM pair of runs shows the loop-time gain against its RAM cost.
+With --fail the exit status is 1 if any operation got slower by more than the
+given percentage and by more than --min cycles; the second limit keeps the
+timing noise of operations that take only a few cycles from failing the check.
+"""
+
+import argparse
+import json
+import sys
+
+MARK = '{"bench": "sloop"'
+
+# the main loop round, used for the loop-time summary line
+LOOP_OP = "parallel_task_run"
+
+
+def load(path):
+    """Return the benchmark object found in a file of text (host output or RTT capture)."""
+    with open(path, "rb") as f:
+        text = f.read().decode("utf-8", "replace")
+    i = text.find(MARK)
+    if i < 0:
+        sys.exit("%s: no sloop benchmark result found" % path)
+    try:
+        obj, _ = json.JSONDecoder().raw_decode(text[i:])
+    except ValueError as e:
+        sys.exit("%s: incomplete benchmark result (%s), RTT lines may have been dropped" % (path, e))
+    if obj.get("dropped", 0):
+        sys.exit("%s: incomplete benchmark result, %d RTT lines were dropped" % (path, obj["dropped"]))
+    return obj
+
+
+def medians(points):
+    return {p["fill"]: p["med"] for p in points}
+
+
+def mean(values):
+    return sum(values) / float(len(values)) if values else 0.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Compare two sloop scheduler benchmark results")
+    ap.add_argument("base", help="baseline result (JSON or RTT channel 0 capture)")
+    ap.add_argument("new", help="new result")
+    ap.add_argument("--fail", type=float, metavar="PCT", help="exit with 1 if an operation is slower by more than PCT %%")
+    ap.add_argument("--min", type=float, default=10, metavar="CYCLES",
+                    help="ignore slowdowns smaller than this many cycles in --fail (default: 10)")
+    args = ap.parse_args()
+
+    base, new = load(args.base), load(args.new)
+
+    if base["cycles_per_ms"] != new["cycles_per_ms"]:
+        print("warning: cycle units differ (%d vs %d per ms)" % (base["cycles_per_ms"], new["cycles_per_ms"]),
+              file=sys.stderr)
+
+    print("%-18s %8s %8s %8s %8s %8s" % ("op", "base@1", "new@1", "base@max", "new@max", "change"))
+
+    worst = None
+    changes = {}
+
+    for op, points in new["ops"].items():
+        if op not in base["ops"]:
+            print("%-18s only in new result" % op)
+            continue
+
+        a, b = medians(base["ops"][op]), medians(points)
+        fills = sorted(set(a) & set(b))
+        if not fills:
+            continue
+
+        ma, mb = mean([a[f] for f in fills]), mean([b[f] for f in fills])
+        change = (mb - ma) * 100.0 / ma if ma else 0.0
+        changes[op] = change
+
+        lo, hi = fills[0], fills[-1]
+        print("%-18s %8d %8d %8d %8d %+7.1f%%" % (op, a[lo], b[lo], a[hi], b[hi], change))
+
+        if mb - ma >= args.min and (worst is None or change > worst[1]):
+            worst = (op, change)
+
+    ram_a, ram_b = base.get("ramfunc_bytes", 0), new.get("ramfunc_bytes", 0)
+    print("ramfunc %d -> %d bytes of RAM (%+d)" % (ram_a, ram_b, ram_b - ram_a))
+
+    if LOOP_OP in changes and ram_b != ram_a:
+        print("loop time %+.1f%% for %+d bytes of RAM" % (changes[LOOP_OP], ram_b - ram_a))
+
+    if args.fail is not None and worst is not None and worst[1] > args.fail:
+        print("regression: %s %+.1f%% (limit %.1f%%)" % (worst[0], worst[1], args.fail), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+sl_log: render a sloop binary log stream (SL_LOG_BINARY 1) back into text.
+
+With binary logging the target sends only the address of a per-call-site
+format descriptor, the ms tick and the raw argument words over RTT
+channel 0 (see project/user/sloop/kernel/sl_log.c). The format strings are
+read from the image that produced the stream, so pass the same .axf/.elf:
+
+    JLinkRTTLogger -Device STM32G030K8 -If SWD -Speed 4000 -RTTChannel 0 log.bin
+    python3 tools/sl_log.py project/MDK-ARM/bin/project.axf log.bin
+
+Use "-" as the log file to read a live stream from stdin, and --no-color
+to strip the ANSI colours the text mode would have produced.
+
+Only target images can be decoded: host builds (project/host) are
+position-independent 64-bit programs and a frame carries just the low 32
+bits of the run-time descriptor address, which does not match the image. If non-empty input
+yields no frame at all, the image does not match the stream and the tool
+exits with status 1.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+# keep in sync with sl_common.h / sl_log.c
+SL_LOG_TEXT, SL_LOG_FUNC, SL_LOG_ERROR, SL_LOG_FOCUS, SL_LOG_WHITE, SL_LOG_YELLOW, SL_LOG_RAW, SL_LOG_WARN = range(8)
+HEAD = struct.Struct("<BII")
+
+RESET = "\x1b[0m"
+GREEN = "\x1b[2;32m"
+YELLOW = "\x1b[2;33m"
+BRIGHT_RED = "\x1b[1;31m"
+BRIGHT_YELLOW = "\x1b[1;33m"
+BRIGHT_WHITE = "\x1b[1;37m"
+
+CONV = re.compile(r"%([-+ #0-9.lh]*)([a-zA-Z%])")
+
+
+class Image:
+    """Minimal ELF reader: maps target addresses to the bytes of allocated sections."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        self.wide = data[4] == 2
+        if self.wide:
+            shoff, = struct.unpack_from("<Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", data, 0x3A)
+            sh = struct.Struct("<IIQQQQIIQQ")
+        else:
+            shoff, = struct.unpack_from("<I", data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+            sh = struct.Struct("<IIIIIIIIII")
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = sh.unpack_from(data, shoff + i * shentsize)[:6]
+            # SHF_ALLOC with file contents (not NOBITS)
+            if flags & 0x2 and sh_type != 8 and size:
+                self.sections.append((addr, size, data[offset:offset + size]))
+
+    def read(self, addr, n):
+        for base, size, blob in self.sections:
+            if base <= addr and addr + n <= base + size:
+                return blob[addr - base:addr - base + n]
+        return None
+
+    def ptr(self, addr):
+        raw = self.read(addr, 8 if self.wide else 4)
+        if raw is None:
+            return None
+        return struct.unpack("<Q" if self.wide else "<I", raw)[0]
+
+    def cstr(self, addr):
+        out = bytearray()
+        while True:
+            b = self.read(addr + len(out), 1)
+            if not b or b == b"\0":
+                return out.decode("gbk", errors="replace") if b else None
+            out += b
+
+
+class Decoder:
+    def __init__(self, image, color=True):
+        self.image = image
+        self.color = color
+        self.cache = {}
+        self.wide = image.wide
+        self.frames = 0
+
+    def desc(self, addr):
+        """Read the sl_log_desc_typ at addr: {fmt, func, type}."""
+        if addr in self.cache:
+            return self.cache[addr]
+        step = 8 if self.wide else 4
+        d = None
+        fmt_p, func_p = self.image.ptr(addr), self.image.ptr(addr + step)
+        raw = self.image.read(addr + 2 * step, 4)
+        if fmt_p is not None and func_p is not None and raw is not None:
+            kind, = struct.unpack("<I", raw)
+            fmt = self.image.cstr(fmt_p)
+            func = self.image.cstr(func_p) if func_p else ""
+            if fmt is not None and func is not None and kind <= SL_LOG_WARN:
+                d = (fmt, func, kind)
+        self.cache[addr] = d
+        return d
+
+    def format(self, fmt, payload):
+        pos = 0
+        out = []
+        last = 0
+        for m in CONV.finditer(fmt):
+            out.append(fmt[last:m.start()])
+            last = m.end()
+            flags, conv = m.group(1).replace("l", "").replace("h", ""), m.group(2)
+            if conv == "%":
+                out.append("%")
+                continue
+            if conv == "s":
+                end = payload.find(b"\0", pos)
+                if end < 0:
+                    out.append("?")
+                    pos = len(payload)
+                    continue
+                out.append(("%" + flags + "s") % payload[pos:end].decode("gbk", errors="replace"))
+                pos = end + 1
+                continue
+            if pos + 4 > len(payload):
+                out.append("?")
+                continue
+            v, = struct.unpack_from("<I", payload, pos)
+            pos += 4
+            if conv == "d" or conv == "i":
+                out.append(("%" + flags + "d") % (v - (1 << 32) if v & 0x80000000 else v))
+            elif conv in "uxX":
+                # SEGGER_RTT_printf prints hex digits in upper case
+                out.append(("%" + flags + conv.replace("x", "X")) % v)
+            elif conv == "c":
+                out.append(chr(v & 0xFF))
+            elif conv == "p":
+                out.append("%08X" % v)
+            else:
+                out.append(m.group(0))
+        out.append(fmt[last:])
+        return "".join(out)
+
+    def render(self, tick, desc, payload):
+        fmt, func, kind = desc
+        c = (lambda s: s) if self.color else (lambda s: "")
+        text = self.format(fmt, payload)
+        if kind == SL_LOG_RAW:
+            return c(YELLOW) + text + c(RESET)
+        if kind == SL_LOG_ERROR:
+            text = c(BRIGHT_RED) + "[error] " + text + c(RESET)
+        elif kind == SL_LOG_WARN:
+            text = c(BRIGHT_YELLOW) + "[warn] " + text + c(RESET)
+        elif kind == SL_LOG_FOCUS:
+            text = c(BRIGHT_WHITE) + "=== " + text + " ===" + c(RESET)
+        elif kind == SL_LOG_WHITE:
+            text = c(BRIGHT_WHITE) + text + c(RESET)
+        elif kind == SL_LOG_YELLOW:
+            text = c(BRIGHT_YELLOW) + text + c(RESET)
+        if kind in (SL_LOG_FUNC, SL_LOG_ERROR, SL_LOG_WARN):
+            text += c(GREEN) + " <func: %s>" % func + c(RESET)
+        s = tick // 1000
+        stamp = "[%02d %02d:%02d:%02d.%03d] " % (s // 86400, s // 3600 % 24, s // 60 % 60, s % 60, tick % 1000)
+        return "\n" + c(GREEN) + stamp + c(YELLOW) + text + "\n" + c(RESET)
+
+    def feed(self, buf):
+        """Decode complete frames from buf, return (text, bytes consumed)."""
+        out = []
+        i = 0
+        while len(buf) - i >= HEAD.size:
+            n, addr, tick = HEAD.unpack_from(buf, i)
+            d = self.desc(addr)
+            if d is None:
+                # not a frame start, resynchronise byte by byte
+                i += 1
+                continue
+            if len(buf) - i < HEAD.size + n:
+                break
+            out.append(self.render(tick, d, bytes(buf[i + HEAD.size:i + HEAD.size + n])))
+            self.frames += 1
+            i += HEAD.size + n
+        return "".join(out), i
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode a sloop binary log stream")
+    ap.add_argument("image", help=".axf/.elf file the target runs")
+    ap.add_argument("log", help="raw RTT channel 0 capture, or - for stdin")
+    ap.add_argument("--no-color", action="store_true", help="strip ANSI colours")
+    args = ap.parse_args()
+
+    dec = Decoder(Image(args.image), color=not args.no_color)
+    src = sys.stdin.buffer if args.log == "-" else open(args.log, "rb")
+    buf = bytearray()
+    total = 0
+    while True:
+        chunk = src.read1(4096) if hasattr(src, "read1") else src.read(4096)
+        if not chunk:
+            break
+        buf += chunk
+        total += len(chunk)
+        text, used = dec.feed(buf)
+        del buf[:used]
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+    if total and dec.frames == 0:
+        sys.exit("error: no frame decoded from %d bytes, is %s the image that produced the log?" % (total, args.image))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""
+sl_scope: decode a sloop variable scope stream into CSV.
+
+The target samples the variables registered with sl_scope_var() from the tick
+interrupt and writes them to RTT up-channel 2 (see
+project/user/sloop/kernel/sl_scope.c). Capture the channel to a file, e.g.
+
+    JLinkRTTLogger -Device STM32G030K8 -If SWD -Speed 4000 -RTTChannel 2 scope.bin
+
+then convert it:
+
+    python3 tools/sl_scope.py scope.bin -o scope.csv --stats
+
+The first column is the target time in ms, one column per variable. A new
+header row is written whenever the variable set changes on the target.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+LAYOUT = 0x5C
+SAMPLE = 0xA5
+
+# keep in sync with sl_common.h SL_SCOPE_xxx
+TYPES = ["<B", "<b", "<H", "<h", "<I", "<i", "<f"]
+TYPE_NAMES = ["u8", "s8", "u16", "s16", "u32", "s32", "f32"]
+
+
+def parse_layout(data, i):
+    """Return (layout, next offset) or None if data[i:] is not a complete layout frame."""
+    if i + 4 > len(data):
+        return None
+    n = data[i + 1]
+    period = data[i + 2] | data[i + 3] << 8
+    if period == 0:
+        return None
+    p = i + 4
+    fields = []
+    for _ in range(n):
+        if p + 2 > len(data):
+            return None
+        t, ln = data[p], data[p + 1]
+        name = data[p + 2:p + 2 + ln]
+        if t >= len(TYPES) or len(name) != ln or not all(0x20 < c < 0x7F for c in name):
+            return None
+        fields.append((name.decode("ascii"), struct.Struct(TYPES[t]), TYPE_NAMES[t]))
+        p += 2 + ln
+    return {"period": period, "fields": fields, "size": 3 + sum(f[1].size for f in fields)}, p
+
+
+def decode(data):
+    """Yield ("layout", layout) and ("sample", time_ms, values); report skipped bytes."""
+    layout = None
+    now = None
+    skipped = 0
+    i = 0
+    while i < len(data):
+        b = data[i]
+        if b == LAYOUT:
+            r = parse_layout(data, i)
+            if r is not None:
+                layout, i = r
+                now = None
+                yield "layout", layout
+                continue
+        elif b == SAMPLE and layout is not None and i + layout["size"] <= len(data):
+            t16 = data[i + 1] | data[i + 2] << 8
+            now = t16 if now is None else now + ((t16 - now) & 0xFFFF)
+            p = i + 3
+            values = []
+            for _, st, _ in layout["fields"]:
+                values.append(st.unpack_from(data, p)[0])
+                p += st.size
+            yield "sample", now, values
+            i = p
+            continue
+        skipped += 1
+        i += 1
+    if skipped:
+        print("warning: %d bytes skipped while resyncing" % skipped, file=sys.stderr)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode a sloop variable scope capture to CSV")
+    ap.add_argument("input", help="raw RTT channel 2 capture")
+    ap.add_argument("-o", "--output", help="output CSV file (default: stdout)")
+    ap.add_argument("--stats", action="store_true", help="print sample rate, gaps and min/max/mean per variable")
+    args = ap.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    w = csv.writer(out)
+
+    layout = None
+    count = 0
+    lost = 0
+    first = last = None
+    stats = {}
+
+    for rec in decode(data):
+        if rec[0] == "layout":
+            layout = rec[1]
+            w.writerow(["time_ms"] + [f[0] for f in layout["fields"]])
+            last = None
+            continue
+
+        _, t, values = rec
+        w.writerow([t] + [("%.6g" % v) if isinstance(v, float) else v for v in values])
+
+        # a gap larger than the period means frames were dropped on a full channel
+        if last is not None and t - last > layout["period"]:
+            lost += (t - last) // layout["period"] - 1
+        first = t if first is None else first
+        last = t
+        count += 1
+
+        for (name, _, _), v in zip(layout["fields"], values):
+            s = stats.setdefault(name, [v, v, 0.0, 0])
+            s[0], s[1], s[2], s[3] = min(s[0], v), max(s[1], v), s[2] + v, s[3] + 1
+
+    if args.output:
+        out.close()
+
+    if args.stats:
+        span = (last - first) if count > 1 else 0
+        rate = (count - 1) * 1000.0 / span if span else 0.0
+        print("%d samples, %.1f Hz, at least %d lost" % (count, rate, lost), file=sys.stderr)
+        for name, (lo, hi, total, n) in stats.items():
+            print("%-20s min %-12g max %-12g mean %g" % (name, lo, hi, total / n), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
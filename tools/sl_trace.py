@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+sl_trace: convert a sloop Flow trace stream into Chrome/Perfetto trace JSON.
+
+The target writes 16-byte records to RTT up-channel 1 (see
+project/user/sloop/kernel/sl_trace.c). Capture the channel to a file, e.g.
+
+    JLinkRTTLogger -Device STM32G030K8 -If SWD -Speed 4000 -RTTChannel 1 trace.bin
+
+then convert it and open the result in https://ui.perfetto.dev or chrome://tracing:
+
+    python3 tools/sl_trace.py trace.bin -m project/MDK-ARM/map/project.map -o trace.json
+
+Pass --summary to print where every Flow is currently parked.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+RECORD = struct.Struct("<IHHIHBB")
+
+MAGIC = 0x534C5452
+HEADER = 0xFF
+LOST = 0xFE
+
+# keep in sync with sl_common.h
+FLOW_OFFSET = 4201
+FLOW_LINE_BASE = FLOW_OFFSET + 1024
+LIFECYCLE = ["INIT", "FREE", "RUN", "IDLE", "EXITED"]
+WHY = ["none", "until", "time", "event", "chan", "select", "take", "call",
+       "resume", "start", "stop", "exit"]
+
+WHY_RESUME = WHY.index("resume")
+
+
+def state_name(state):
+    if FLOW_OFFSET <= state < FLOW_OFFSET + len(LIFECYCLE):
+        return LIFECYCLE[state - FLOW_OFFSET]
+    if state >= FLOW_LINE_BASE:
+        return "L%d" % (state - FLOW_LINE_BASE)
+    return "state %d" % state
+
+
+def why_name(why):
+    return WHY[why] if why < len(WHY) else "why %d" % why
+
+
+def load_symbols(path):
+    """Map flow_state_<name> addresses to Flow names from a Keil map, GNU map or nm listing."""
+    names = {}
+    keil = re.compile(r"^\s*flow_state_(\w+)\s+0x([0-9a-fA-F]+)\s")
+    gnu = re.compile(r"^\s*0x([0-9a-fA-F]+)\s+flow_state_(\w+)\s*$")
+    nm = re.compile(r"^([0-9a-fA-F]+)\s+\w\s+flow_state_(\w+)\s*$")
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            m = keil.match(line)
+            if m:
+                names[int(m.group(2), 16) & 0xFFFFFFFF] = m.group(1)
+                continue
+            m = gnu.match(line) or nm.match(line)
+            if m:
+                names[int(m.group(1), 16) & 0xFFFFFFFF] = m.group(2)
+    return names
+
+
+def parse(data, sub_per_ms):
+    """Yield (time_us, flow, from, to, why) and report lost records."""
+    lost = 0
+    seq = None
+    n = len(data) // RECORD.size
+    for i in range(n):
+        tick, sub, frm, flow, to, why, s = RECORD.unpack_from(data, i * RECORD.size)
+        if flow == MAGIC and why == HEADER:
+            sub_per_ms = tick or sub_per_ms
+            seq = None
+            continue
+        if flow == MAGIC and why == LOST:
+            # exact count of records overwritten on target; the sequence gap that follows is the same loss
+            lost += tick
+            seq = None
+            continue
+        if seq is not None and s != (seq + 1) & 0xFF:
+            lost += (s - seq - 1) & 0xFF
+        seq = s
+        yield tick * 1000.0 + sub * 1000.0 / sub_per_ms, flow, frm, to, why
+    if len(data) % RECORD.size:
+        print("warning: %d trailing bytes ignored" % (len(data) % RECORD.size), file=sys.stderr)
+    if lost:
+        print("warning: %d records lost" % lost, file=sys.stderr)
+
+
+def convert(records, names):
+    events = []
+    tids = {}
+    parked = {}
+    last = {}
+    end = 0.0
+
+    def tid_of(flow):
+        if flow not in tids:
+            tids[flow] = len(tids) + 1
+            events.append({"ph": "M", "name": "thread_name", "pid": 1, "tid": tids[flow],
+                           "args": {"name": names.get(flow, "flow@0x%08X" % flow)}})
+        return tids[flow]
+
+    for ts, flow, frm, to, why in records:
+        tid = tid_of(flow)
+        end = max(end, ts)
+        last[flow] = (ts, frm, to, why)
+        if why == WHY_RESUME:
+            start = parked.pop(flow, None)
+            if start is not None:
+                events.append({"ph": "X", "pid": 1, "tid": tid, "ts": start[0], "dur": ts - start[0],
+                               "name": "wait %s @%s" % (why_name(start[1]), state_name(frm)),
+                               "args": {"from": state_name(start[2]), "state": state_name(frm)}})
+        elif to >= FLOW_LINE_BASE:
+            parked[flow] = (ts, why, frm)
+        else:
+            parked.pop(flow, None)
+            events.append({"ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts,
+                           "name": "%s -> %s" % (state_name(frm), state_name(to)),
+                           "args": {"why": why_name(why)}})
+
+    # still parked at the end of the capture: the likely stall points
+    for flow, (ts, why, frm) in parked.items():
+        line = state_name(last[flow][2])
+        events.append({"ph": "X", "pid": 1, "tid": tids[flow], "ts": ts, "dur": max(end - ts, 1),
+                       "name": "wait %s @%s (parked)" % (why_name(why), line),
+                       "args": {"from": state_name(frm), "state": line, "parked": True}})
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}, last
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Convert a sloop Flow trace to Chrome/Perfetto JSON")
+    ap.add_argument("input", help="raw RTT channel 1 capture")
+    ap.add_argument("-o", "--output", help="output JSON file (default: stdout)")
+    ap.add_argument("-m", "--map", help="Keil/GNU map file or nm listing to name Flows")
+    ap.add_argument("--sub-per-ms", type=int, default=64000,
+                    help="SysTick counts per ms if the capture has no header record (default 64000)")
+    ap.add_argument("--summary", action="store_true", help="print the last state of every Flow")
+    args = ap.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    names = load_symbols(args.map) if args.map else {}
+    trace, last = convert(parse(data, args.sub_per_ms), names)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump(trace, out, indent=1)
+    if args.output:
+        out.close()
+
+    if args.summary:
+        for flow, (ts, frm, to, why) in sorted(last.items(), key=lambda x: x[1][0]):
+            name = names.get(flow, "flow@0x%08X" % flow)
+            print("%-24s %10.3f ms  %s -> %s (%s)" % (name, ts / 1000.0, state_name(frm), state_name(to), why_name(why)),
+                  file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()